@@ -2,21 +2,37 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in mat4 aInstanceModel;   // consumes locations 2,3,4,5
-layout(location = 6) in vec3 aInstanceColor;
+layout(location = 6) in int aComponentIndex;     // component store row of this instance
 
 uniform mat4 uModel;          // used only when uUseInstancing == false
 uniform mat4 uView;
 uniform mat4 uProjection;
 uniform vec3 uColor;          // used only when uUseInstancing == false
 uniform bool uUseInstancing;
+uniform samplerBuffer uComponentVoltages;   // one voltage per component store row
+uniform float uMaxVoltage;
+uniform int uHoverIndex;                    // store row under the cursor, or -1
+uniform uint uPickId;                       // used only when uUseInstancing == false
 
 out vec3 vNormal;
 out vec3 vFragPos;
 out vec3 vColor;
+flat out uint vPickId;    // read only by pick.frag
 
 void main() {
     mat4 model = uUseInstancing ? aInstanceModel : uModel;
-    vColor = uUseInstancing ? aInstanceColor : uColor;
+    if (uUseInstancing) {
+        float voltage = texelFetch(uComponentVoltages, aComponentIndex).r;
+        float normV = clamp(voltage / uMaxVoltage, 0.0, 1.0);
+        vColor = mix(vec3(0.0, 0.0, 1.0), vec3(1.0, 0.0, 0.0), normV);
+        if (aComponentIndex == uHoverIndex) {
+            vColor = vec3(1.0, 1.0, 0.0);
+        }
+        vPickId = uint(aComponentIndex) + 1u;
+    } else {
+        vColor = uColor;
+        vPickId = uPickId;
+    }
     vFragPos = vec3(model * vec4(aPos, 1.0));
     // Inverse-transpose handles rotation correctly even though most model
     // matrices here are translation-only -  components do rotate per frame.
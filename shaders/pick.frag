@@ -0,0 +1,8 @@
+#version 330 core
+flat in uint vPickId;   // see PickBuffer.h for the encoding
+
+out uint fragId;
+
+void main() {
+    fragId = vPickId;
+}
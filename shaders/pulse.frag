@@ -0,0 +1,11 @@
+#version 330 core
+in float vBrightness;
+
+out vec4 FragColor;
+
+uniform vec3 objectColor;
+
+void main()
+{
+    FragColor = vec4(objectColor * vBrightness, 1.0);
+}
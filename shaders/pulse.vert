@@ -0,0 +1,21 @@
+#version 330 core
+layout(location = 0) in vec3 aFrom;   // per-instance connection endpoints
+layout(location = 1) in vec3 aTo;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float uTime;
+uniform float uPeriod;       // seconds for one pulse to cross a connection
+uniform float uTrailStep;    // seconds between neighbouring trail points
+uniform float uTrailFade;    // brightness lost per trail point
+
+out float vBrightness;
+
+void main() {
+    // Vertex k of an instance is where the pulse was k steps ago, so the
+    // trail needs no history: it is the same line sampled further back.
+    float k = float(gl_VertexID);
+    float t = fract((uTime - k * uTrailStep) / uPeriod);
+    vBrightness = 1.0 - (k + 1.0) * uTrailFade;
+    gl_Position = projection * view * vec4(mix(aFrom, aTo, t), 1.0);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;   // unit sphere
+layout(location = 1) in vec3 aP0;    // per-instance Bezier control points of the wire
+layout(location = 2) in vec3 aP1;
+layout(location = 3) in vec3 aP2;
+layout(location = 4) in vec3 aP3;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float uTime;
+uniform float uSignalSpeed;
+uniform float uSignalRadius;
+uniform vec3 uSignalColor;
+
+out vec3 vColor;
+
+// Same curve as bezierPoint in WireRenderer.cpp.
+vec3 bezierPoint(float t) {
+    float u = 1.0 - t;
+    return u * u * u * aP0 + 3.0 * u * u * t * aP1 + 3.0 * u * t * t * aP2 + t * t * t * aP3;
+}
+
+void main() {
+    // Every pulse runs the full wire once per 1 / uSignalSpeed seconds.
+    float t = fract(uTime * uSignalSpeed);
+    vColor = uSignalColor;
+    gl_Position = projection * view * vec4(bezierPoint(t) + uSignalRadius * aPos, 1.0);
+}
@@ -1,8 +1,8 @@
 #version 330 core
-out vec4 fragColor;
+in vec3 vColor;
 
-uniform vec3 objectColor;
+out vec4 fragColor;
 
 void main() {
-    fragColor = vec4(objectColor, 1.0);
+    fragColor = vec4(vColor, 1.0);
 }
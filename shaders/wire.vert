@@ -1,10 +1,19 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aColor;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec3 objectColor;        // used only when uUseVertexColor == false
+uniform bool uUseVertexColor;    // true for the merged tube buffer
+uniform uint uPickId;            // read only by pick.frag
+
+out vec3 vColor;
+flat out uint vPickId;
 
 void main() {
+    vColor = uUseVertexColor ? aColor : objectColor;
+    vPickId = uPickId;
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
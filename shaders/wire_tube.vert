@@ -0,0 +1,49 @@
+#version 330 core
+layout(location = 0) in vec2 aTubeCoord;   // x: curve parameter t, y: angle around the tube
+layout(location = 1) in vec3 aP0;          // per-instance Bezier control points
+layout(location = 2) in vec3 aP1;
+layout(location = 3) in vec3 aP2;
+layout(location = 4) in vec3 aP3;
+layout(location = 5) in vec3 aColor;
+layout(location = 6) in int aConnection;   // index into graph.connections
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float uTubeRadius;
+
+out vec3 vColor;
+flat out uint vPickId;    // read only by pick.frag
+
+const vec3 WORLD_UP = vec3(0.0, 1.0, 0.0);
+const vec3 WORLD_RIGHT = vec3(1.0, 0.0, 0.0);
+const vec3 FALLBACK_TANGENT = vec3(0.0, 0.0, 1.0);
+const float TANGENT_EPSILON = 1e-4;
+const float UP_DOT_LIMIT = 0.99;
+const uint PICK_ID_WIRE_BIT = 0x80000000u;   // same as PickBuffer.h
+
+// Same curve and cross-section frame as bezierPoint, bezierTangent and
+// buildFrame in WireRenderer.cpp, so both tessellation paths agree.
+vec3 bezierPoint(float t) {
+    float u = 1.0 - t;
+    return u * u * u * aP0 + 3.0 * u * u * t * aP1 + 3.0 * u * t * t * aP2 + t * t * t * aP3;
+}
+
+vec3 bezierTangent(float t) {
+    float u = 1.0 - t;
+    return 3.0 * u * u * (aP1 - aP0) + 6.0 * u * t * (aP2 - aP1) + 3.0 * t * t * (aP3 - aP2);
+}
+
+void main() {
+    float t = aTubeCoord.x;
+    vec3 tangent = bezierTangent(t);
+    tangent = length(tangent) < TANGENT_EPSILON ? FALLBACK_TANGENT : normalize(tangent);
+
+    vec3 upReference = abs(dot(tangent, WORLD_UP)) < UP_DOT_LIMIT ? WORLD_UP : WORLD_RIGHT;
+    vec3 binormal = normalize(cross(tangent, upReference));
+    vec3 normal = cross(binormal, tangent);
+    vec3 radial = cos(aTubeCoord.y) * normal + sin(aTubeCoord.y) * binormal;
+
+    vColor = aColor;
+    vPickId = PICK_ID_WIRE_BIT | uint(aConnection + 1);
+    gl_Position = projection * view * vec4(bezierPoint(t) + uTubeRadius * radial, 1.0);
+}
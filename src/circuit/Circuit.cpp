@@ -1,150 +1,684 @@
 #include "Circuit.h"
 
 #include <algorithm>
-#include <functional>
+#include <atomic>
+#include <limits>
+#include <utility>
 
-std::unordered_map<int, std::vector<int>> CircuitGraph::buildAdjacency() const
+ComponentIndex::ComponentIndex(const std::vector<Component>& components)
 {
-    std::unordered_map<int, std::vector<int>> adj;
-    for (const auto& conn : connections) {
-        adj[conn.from_id].push_back(conn.to_id);
-        adj[conn.to_id].push_back(conn.from_id);
+    if (components.empty()) {
+        return;
+    }
+
+    int minId = std::numeric_limits<int>::max();
+    int maxId = std::numeric_limits<int>::min();
+    for (const auto& c : components) {
+        minId = std::min(minId, c.id);
+        maxId = std::max(maxId, c.id);
+    }
+
+    const int64_t span = static_cast<int64_t>(maxId) - minId + 1;
+    if (span <= static_cast<int64_t>(components.size()) * 4 + 64) {
+        m_base = minId;
+        m_table.assign(static_cast<size_t>(span), -1);
+        for (size_t i = 0; i < components.size(); ++i) {
+            int& slot = m_table[static_cast<size_t>(components[i].id - minId)];
+            if (slot == -1) {
+                slot = static_cast<int>(i);
+            }
+        }
+    } else {
+        m_sparse.reserve(components.size());
+        for (size_t i = 0; i < components.size(); ++i) {
+            m_sparse.emplace(components[i].id, static_cast<int>(i));
+        }
+    }
+}
+
+uint64_t CircuitGraph::NextTopologyVersion()
+{
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+uint64_t CircuitGraph::topologyVersion() const
+{
+    // Connectivity applies the unrecorded-resize guard and is kept current
+    // incrementally, so asking for the version never builds the adjacency.
+    return connectivity().version;
+}
+
+void CircuitGraph::markTopologyChanged()
+{
+    bumpTopologyVersion();
+    m_componentRevision = NextTopologyVersion();
+}
+
+void CircuitGraph::bumpTopologyVersion()
+{
+    m_topologyVersion = NextTopologyVersion();
+    m_topology.reset();
+}
+
+void CircuitGraph::markComponentAdded()
+{
+    const uint64_t previous = m_topologyVersion;
+    bumpTopologyVersion();
+    if (CircuitConnectivity* state = connectivityForAppend(previous, 1, 0)) {
+        if (!state->addComponent(components.back())) {
+            m_connectivity.reset();
+        }
+    }
+
+    const uint64_t previousRevision = m_componentRevision;
+    m_componentRevision = NextTopologyVersion();
+    if (ComponentStore* store = componentStoreForEdit(previousRevision, 1)) {
+        store->append(components.back());
     }
-    return adj;
 }
 
-std::vector<int> CircuitGraph::findDisconnectedComponents() const
+void CircuitGraph::markComponentEdited(int id)
 {
-    return FindDisconnectedComponents(components, connections);
+    const uint64_t previousRevision = m_componentRevision;
+    m_componentRevision = NextTopologyVersion();
+    ComponentStore* store = componentStoreForEdit(previousRevision, 0);
+    if (!store) {
+        return;
+    }
+
+    const int index = store->indexOf(id);
+    if (index < 0 || components[static_cast<size_t>(index)].id != id) {
+        // Not in step after all; let the next query rebuild it.
+        m_store->revision = 0;
+        return;
+    }
+    store->update(static_cast<size_t>(index), components[static_cast<size_t>(index)]);
+}
+
+void CircuitGraph::markConnectionAdded()
+{
+    const uint64_t previous = m_topologyVersion;
+    bumpTopologyVersion();
+    if (CircuitConnectivity* state = connectivityForAppend(previous, 0, 1)) {
+        state->addConnection(connections.back());
+    }
+}
+
+CircuitConnectivity* CircuitGraph::connectivityForAppend(uint64_t previousVersion,
+                                                         size_t addedComponents,
+                                                         size_t addedConnections)
+{
+    // The caller has already appended, so the state is usable only if it
+    // matched the lists just before that append.
+    if (!m_connectivity || m_connectivity->version != previousVersion
+        || m_connectivity->componentCount() + addedComponents != components.size()
+        || m_connectivity->connectionCount() + addedConnections != connections.size()) {
+        m_connectivity.reset();
+        return nullptr;
+    }
+
+    // Graph copies share the state; copy before writing so they keep theirs.
+    if (m_connectivity.use_count() > 1) {
+        m_connectivity = std::make_shared<CircuitConnectivity>(*m_connectivity);
+    }
+    m_connectivity->version = m_topologyVersion;
+    return m_connectivity.get();
+}
+
+CircuitConnectivity& CircuitGraph::connectivity() const
+{
+    const bool sizesMatch = m_connectivity
+        && m_connectivity->componentCount() == components.size()
+        && m_connectivity->connectionCount() == connections.size();
+    if (m_connectivity && m_connectivity->version == m_topologyVersion && sizesMatch) {
+        return *m_connectivity;
+    }
+
+    // Same guard as topology(): an unrecorded resize gets a new version.
+    if (m_connectivity && m_connectivity->version == m_topologyVersion && !sizesMatch) {
+        m_topologyVersion = NextTopologyVersion();
+    }
+
+    auto rebuilt = std::make_shared<CircuitConnectivity>();
+    rebuilt->version = m_topologyVersion;
+    rebuilt->rebuild(components, connections);
+    m_connectivity = std::move(rebuilt);
+    return *m_connectivity;
+}
+
+ComponentStore* CircuitGraph::componentStoreForEdit(uint64_t previousRevision, size_t addedComponents)
+{
+    if (!m_store || m_store->revision != previousRevision
+        || m_store->size() + addedComponents != components.size()) {
+        return nullptr;
+    }
+
+    // Graph copies share the store; copy before writing so they keep theirs.
+    if (m_store.use_count() > 1) {
+        m_store = std::make_shared<ComponentStore>(*m_store);
+    }
+    m_store->revision = m_componentRevision;
+    return m_store.get();
+}
+
+const ComponentStore& CircuitGraph::componentStore() const
+{
+    if (m_store && m_store->revision == m_componentRevision && m_store->size() == components.size()) {
+        return *m_store;
+    }
+
+    // Same guard as topology(): an unrecorded resize gets a new revision.
+    if (m_store && m_store->revision == m_componentRevision) {
+        m_componentRevision = NextTopologyVersion();
+    }
+
+    // Rebuilding in place keeps the ID high-water mark; a shared store is copied first.
+    if (!m_store) {
+        m_store = std::make_shared<ComponentStore>();
+    } else if (m_store.use_count() > 1) {
+        m_store = std::make_shared<ComponentStore>(*m_store);
+    }
+    m_store->revision = m_componentRevision;   // before assign(), which starts the edit log here
+    m_store->assign(components);
+    return *m_store;
+}
+
+uint64_t CircuitGraph::componentRevision() const
+{
+    return componentStore().revision;
+}
+
+CircuitSnapshot CircuitGraph::snapshot() const
+{
+    // Building the analysis also builds connectivity, and componentRevision()
+    // builds the store; the copy then shares both, and later shares loop
+    // membership through the analysis once either graph asks for it.
+    const uint64_t version = analysis()->topologyVersion;
+    const uint64_t revision = componentRevision();
+    if (m_snapshot && m_snapshot->m_topologyVersion == version
+        && m_snapshot->m_componentRevision == revision) {
+        return m_snapshot;
+    }
+
+    auto copy = std::make_shared<CircuitGraph>(*this);
+    copy->m_snapshot.reset();   // a snapshot must not pin its predecessor
+    m_snapshot = std::move(copy);
+    return m_snapshot;
+}
+
+const AdjacencyCSR& CircuitGraph::adjacency() const
+{
+    return topology().adjacency;
+}
+
+const ComponentIndex& CircuitGraph::componentIndex() const
+{
+    return topology().index;
+}
+
+int CircuitGraph::indexOf(int id) const
+{
+    const ComponentStore& store = componentStore();
+    const int index = store.indexOf(id);
+    if (index < 0 || components[static_cast<size_t>(index)].id == id) {
+        return index;
+    }
+
+    // An ID was rewritten without markComponentEdited(); rebuild once.
+    m_componentRevision = NextTopologyVersion();
+    const ComponentStore& rebuilt = componentStore();
+    return rebuilt.indexOf(id);
+}
+
+Component* CircuitGraph::findComponent(int id)
+{
+    const int index = indexOf(id);
+    return index < 0 ? nullptr : &components[static_cast<size_t>(index)];
+}
+
+const Component* CircuitGraph::findComponent(int id) const
+{
+    const int index = indexOf(id);
+    return index < 0 ? nullptr : &components[static_cast<size_t>(index)];
+}
+
+int CircuitGraph::nextComponentId() const
+{
+    return componentStore().nextFreeId();
+}
+
+const CircuitTopology& CircuitGraph::topology() const
+{
+    const bool sizesMatch = m_topology
+        && m_topology->componentCount == components.size()
+        && m_topology->connectionCount == connections.size();
+    if (m_topology && m_topology->version == m_topologyVersion && sizesMatch) {
+        return *m_topology;
+    }
+
+    // Someone resized the lists without markTopologyChanged(); never serve
+    // that stale adjacency under the old version number.
+    if (m_topology && m_topology->version == m_topologyVersion && !sizesMatch) {
+        m_topologyVersion = NextTopologyVersion();
+    }
+
+    auto rebuilt = std::make_shared<CircuitTopology>();
+    rebuilt->version = m_topologyVersion;
+    rebuilt->componentCount = components.size();
+    rebuilt->connectionCount = connections.size();
+    rebuilt->index = ComponentIndex(components);
+    rebuilt->adjacency = BuildAdjacencyCSR(components, connections, rebuilt->index);
+    m_topology = std::move(rebuilt);
+    return *m_topology;
+}
+
+AdjacencyCSR CircuitGraph::buildAdjacency() const
+{
+    return BuildAdjacencyCSR(components, connections);
+}
+
+const std::vector<int>& CircuitGraph::findDisconnectedComponents() const
+{
+    return connectivity().disconnected(components);
 }
 
 bool CircuitGraph::isCircuitLooped() const
 {
-    return IsCircuitLooped(components, connections);
+    return connectivity().hasCycle();
 }
 
 std::unordered_set<int> CircuitGraph::findLoopedComponents() const
 {
-    return FindLoopedComponents(components, connections);
+    return cycleAnalysis().loopedComponents;
 }
 
-std::vector<int> FindDisconnectedComponents(const std::vector<Component>& components,
-                                            const std::vector<Connection>& connections)
+CycleAnalysis CircuitGraph::analyzeCycles() const
+{
+    return AnalyzeCycles(components, adjacency());
+}
+
+std::shared_ptr<const CircuitAnalysis> CircuitGraph::analysis() const
 {
-    std::unordered_set<int> visited;
-    std::unordered_map<int, std::vector<int>> adj;
+    // topologyVersion() applies the unrecorded-resize guard first.
+    const uint64_t version = topologyVersion();
+    if (m_analysis && m_analysis->topologyVersion == version) {
+        return m_analysis;
+    }
 
-    for (const auto& conn : connections) {
-        adj[conn.from_id].push_back(conn.to_id);
-        adj[conn.to_id].push_back(conn.from_id);
+    CircuitConnectivity& state = connectivity();
+    auto computed = std::make_shared<CircuitAnalysis>();
+    computed->topologyVersion = version;
+    computed->hasCycle = state.hasCycle();
+    computed->disconnected = state.disconnected(components);
+    m_analysis = std::move(computed);
+    return m_analysis;
+}
+
+const CycleAnalysis& CircuitGraph::cycleAnalysis() const
+{
+    const std::shared_ptr<const CircuitAnalysis> current = analysis();
+    if (!current->m_cycles) {
+        current->m_cycles = std::make_shared<const CycleAnalysis>(analyzeCycles());
     }
+    return *current->m_cycles;
+}
 
-    std::function<void(int)> dfs = [&](int node) {
-        visited.insert(node);
-        for (int neighbor : adj[node]) {
-            if (!visited.count(neighbor)) {
-                dfs(neighbor);
-            }
-        }
-    };
+AdjacencyCSR BuildAdjacencyCSR(const std::vector<Component>& components,
+                               const std::vector<Connection>& connections)
+{
+    return BuildAdjacencyCSR(components, connections, ComponentIndex(components));
+}
+
+AdjacencyCSR BuildAdjacencyCSR(const std::vector<Component>& components,
+                               const std::vector<Connection>& connections,
+                               const ComponentIndex& lookup)
+{
+    AdjacencyCSR adjacency;
+    const size_t n = components.size();
+    adjacency.offsets.assign(n + 1, 0);
+    adjacency.connectionCount = static_cast<int>(connections.size());
 
-    if (!components.empty()) {
-        dfs(components[0].id);
+    // Pass 1 - resolve endpoints once and count each node's degree.
+    std::vector<std::pair<int, int>> endpoints(connections.size(), {-1, -1});
+    for (size_t e = 0; e < connections.size(); ++e) {
+        const int from = lookup.find(connections[e].from_id);
+        const int to = lookup.find(connections[e].to_id);
+        if (from < 0 || to < 0) {
+            continue;
+        }
+        if (from == to) {
+            adjacency.selfLoopNodes.push_back(from);
+            continue;
+        }
+        endpoints[e] = {from, to};
+        ++adjacency.offsets[static_cast<size_t>(from) + 1];
+        ++adjacency.offsets[static_cast<size_t>(to) + 1];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        adjacency.offsets[i + 1] += adjacency.offsets[i];
     }
 
-    std::vector<int> disconnected;
-    for (const auto& c : components) {
-        if (!visited.count(c.id)) {
-            disconnected.push_back(c.id);
+    // Pass 2 - scatter both directions of every connection into place.
+    const size_t entries = static_cast<size_t>(adjacency.offsets[n]);
+    adjacency.neighbors.resize(entries);
+    adjacency.edges.resize(entries);
+    std::vector<int> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t e = 0; e < endpoints.size(); ++e) {
+        const auto [from, to] = endpoints[e];
+        if (from < 0) {
+            continue;
         }
+        const size_t forward = static_cast<size_t>(cursor[static_cast<size_t>(from)]++);
+        adjacency.neighbors[forward] = to;
+        adjacency.edges[forward] = static_cast<int>(e);
+        const size_t backward = static_cast<size_t>(cursor[static_cast<size_t>(to)]++);
+        adjacency.neighbors[backward] = from;
+        adjacency.edges[backward] = static_cast<int>(e);
     }
 
-    return disconnected;
+    return adjacency;
 }
 
-bool HasCycleDFS(int node, int parent,
-                 const std::unordered_map<int, std::vector<int>>& adj,
-                 std::unordered_set<int>& visited)
+std::vector<int> FindDisconnectedComponents(const std::vector<Component>& components,
+                                            const std::vector<Connection>& connections)
 {
-    visited.insert(node);
-    for (int neighbor : adj.at(node)) {
-        if (!visited.count(neighbor)) {
-            if (HasCycleDFS(neighbor, node, adj, visited)) {
-                return true;
-            }
-        } else if (neighbor != parent) {
-            return true;
-        }
-    }
-    return false;
+    return FindDisconnectedComponents(components, BuildAdjacencyCSR(components, connections));
 }
 
-bool IsCircuitLooped(const std::vector<Component>& components,
-                     const std::vector<Connection>& connections)
+std::vector<int> FindDisconnectedComponents(const std::vector<Component>& components,
+                                            const AdjacencyCSR& adjacency)
 {
-    std::unordered_map<int, std::vector<int>> adj;
-    for (const auto& conn : connections) {
-        adj[conn.from_id].push_back(conn.to_id);
-        adj[conn.to_id].push_back(conn.from_id);
+    std::vector<int> disconnected;
+    const int n = adjacency.nodeCount();
+    if (n == 0) {
+        return disconnected;
     }
 
-    std::unordered_set<int> visited;
-    for (const auto& c : components) {
-        if (!visited.count(c.id)) {
-            if (HasCycleDFS(c.id, -1, adj, visited)) {
-                return true;
+    // Explicit stack instead of recursion: deep chains cannot overflow it.
+    VisitedBitset visited(n);
+    std::vector<int> stack;
+    stack.push_back(0);
+    visited.set(0);
+    while (!stack.empty()) {
+        const int node = stack.back();
+        stack.pop_back();
+        for (int entry = adjacency.offsets[static_cast<size_t>(node)];
+             entry < adjacency.offsets[static_cast<size_t>(node) + 1]; ++entry) {
+            const int neighbor = adjacency.neighbors[static_cast<size_t>(entry)];
+            if (!visited.test(neighbor)) {
+                visited.set(neighbor);
+                stack.push_back(neighbor);
             }
         }
     }
-    return false;
+
+    for (int i = 0; i < n; ++i) {
+        if (!visited.test(i)) {
+            disconnected.push_back(components[static_cast<size_t>(i)].id);
+        }
+    }
+
+    return disconnected;
+}
+
+bool IsCircuitLooped(const std::vector<Component>& components,
+                     const std::vector<Connection>& connections)
+{
+    // Every loop puts at least one component into the looped set.
+    return !AnalyzeCycles(components, connections).loopedComponents.empty();
 }
 
 std::unordered_set<int> FindLoopedComponents(const std::vector<Component>& components,
                                              const std::vector<Connection>& connections)
 {
-    std::unordered_map<int, std::vector<int>> adj;
-    for (const auto& conn : connections) {
-        adj[conn.from_id].push_back(conn.to_id);
-        adj[conn.to_id].push_back(conn.from_id);
+    return AnalyzeCycles(components, connections).loopedComponents;
+}
+
+CycleAnalysis AnalyzeCycles(const std::vector<Component>& components,
+                            const std::vector<Connection>& connections)
+{
+    return AnalyzeCycles(components, BuildAdjacencyCSR(components, connections));
+}
+
+CycleAnalysis AnalyzeCycles(const std::vector<Component>& components,
+                            const AdjacencyCSR& adjacency)
+{
+    CycleAnalysis result;
+    const int n = adjacency.nodeCount();
+
+    // A component wired to itself is a one-edge loop.
+    for (int node : adjacency.selfLoopNodes) {
+        result.loopedComponents.insert(components[static_cast<size_t>(node)].id);
     }
 
-    std::unordered_set<int> visited, inCycle;
+    // Iterative DFS so long chains cannot overflow the call stack. Each
+    // neighbor entry carries its connection index, so the DFS skips exactly
+    // the edge it arrived on and still sees a parallel connection back to
+    // the parent as a cycle. disc = discovery order, low = earliest
+    // discovery reachable through one back edge from the subtree.
+    struct Frame {
+        int node;
+        int parentEdge;
+        int next;
+    };
+    std::vector<int> disc(static_cast<size_t>(n), -1);
+    std::vector<int> low(static_cast<size_t>(n), 0);
+    VisitedBitset isArticulation(n);
+    VisitedBitset isBridge(adjacency.connectionCount);
+    std::vector<Frame> stack;
+    int time = 0;
+
+    for (int root = 0; root < n; ++root) {
+        if (disc[static_cast<size_t>(root)] != -1) {
+            continue;
+        }
 
-    std::function<bool(int, int, std::vector<int>&)> dfs =
-        [&](int node, int parent, std::vector<int>& path) {
-            visited.insert(node);
-            path.push_back(node);
+        int rootChildren = 0;
+        disc[static_cast<size_t>(root)] = low[static_cast<size_t>(root)] = time++;
+        stack.push_back({root, -1, adjacency.offsets[static_cast<size_t>(root)]});
 
-            for (int neighbor : adj[node]) {
-                if (neighbor == parent) {
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            const int u = frame.node;
+
+            if (frame.next < adjacency.offsets[static_cast<size_t>(u) + 1]) {
+                const size_t entry = static_cast<size_t>(frame.next++);
+                const int edge = adjacency.edges[entry];
+                if (edge == frame.parentEdge) {
                     continue;
                 }
 
-                if (!visited.count(neighbor)) {
-                    if (dfs(neighbor, node, path)) {
-                        return true;
+                const int v = adjacency.neighbors[entry];
+                if (disc[static_cast<size_t>(v)] == -1) {
+                    disc[static_cast<size_t>(v)] = low[static_cast<size_t>(v)] = time++;
+                    if (u == root) {
+                        ++rootChildren;
                     }
+                    stack.push_back({v, edge, adjacency.offsets[static_cast<size_t>(v)]});
                 } else {
-                    auto it = std::find(path.begin(), path.end(), neighbor);
-                    if (it != path.end()) {
-                        for (; it != path.end(); ++it) {
-                            inCycle.insert(*it);
-                        }
-                        inCycle.insert(neighbor);
-                    }
+                    low[static_cast<size_t>(u)] = std::min(low[static_cast<size_t>(u)], disc[static_cast<size_t>(v)]);
                 }
+                continue;
             }
 
-            path.pop_back();
-            return false;
-        };
+            // u is finished; fold its low-link into the parent and classify the tree edge.
+            const int parentEdge = frame.parentEdge;
+            stack.pop_back();
+            if (stack.empty()) {
+                continue;
+            }
 
-    for (const auto& c : components) {
-        if (!visited.count(c.id)) {
-            std::vector<int> path;
-            dfs(c.id, -1, path);
+            const int p = stack.back().node;
+            low[static_cast<size_t>(p)] = std::min(low[static_cast<size_t>(p)], low[static_cast<size_t>(u)]);
+            if (low[static_cast<size_t>(u)] > disc[static_cast<size_t>(p)]) {
+                isBridge.set(parentEdge);
+            }
+            if (p != root && low[static_cast<size_t>(u)] >= disc[static_cast<size_t>(p)]) {
+                isArticulation.set(p);
+            }
+        }
+
+        if (rootChildren > 1) {
+            isArticulation.set(root);
+        }
+    }
+
+    for (int edge = 0; edge < adjacency.connectionCount; ++edge) {
+        if (isBridge.test(edge)) {
+            result.bridges.push_back(static_cast<size_t>(edge));
+        }
+    }
+
+    // Every edge that is not a bridge lies on some cycle, and so do its endpoints.
+    for (int u = 0; u < n; ++u) {
+        for (int entry = adjacency.offsets[static_cast<size_t>(u)];
+             entry < adjacency.offsets[static_cast<size_t>(u) + 1]; ++entry) {
+            if (!isBridge.test(adjacency.edges[static_cast<size_t>(entry)])) {
+                result.loopedComponents.insert(components[static_cast<size_t>(u)].id);
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < n; ++i) {
+        if (isArticulation.test(i)) {
+            result.articulationPoints.push_back(components[static_cast<size_t>(i)].id);
+        }
+    }
+
+    return result;
+}
+
+#ifdef ELEC3D_TEST_CYCLES
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <set>
+
+namespace {
+
+/// Number of connected pieces left after dropping connection skipEdge and
+/// every connection touching row skipRow (-1 drops nothing). A dropped row
+/// is not counted as a piece.
+int CountPieces(int n, const std::vector<std::pair<int, int>>& edges, int skipEdge, int skipRow)
+{
+    std::vector<int> parent(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        parent[static_cast<size_t>(i)] = i;
+    }
+    const auto find = [&parent](int x) {
+        while (parent[static_cast<size_t>(x)] != x) {
+            x = parent[static_cast<size_t>(x)] = parent[static_cast<size_t>(parent[static_cast<size_t>(x)])];
+        }
+        return x;
+    };
+    int pieces = skipRow >= 0 ? n - 1 : n;
+    for (size_t e = 0; e < edges.size(); ++e) {
+        const int a = edges[e].first;
+        const int b = edges[e].second;
+        if (static_cast<int>(e) == skipEdge || a == skipRow || b == skipRow) {
+            continue;
+        }
+        const int rootA = find(a);
+        const int rootB = find(b);
+        if (rootA != rootB) {
+            parent[static_cast<size_t>(rootA)] = rootB;
+            --pieces;
         }
     }
+    return pieces;
+}
+
+} // namespace
+
+/// Parallel connections and self-loops count as loops, and a connection to
+/// an ID that is not on the board is ignored.
+void TestCycleAnalysisEdgeCases()
+{
+    std::vector<Component> components(3);
+    for (int id = 0; id < 3; ++id) {
+        components[static_cast<size_t>(id)].id = id;
+    }
+
+    const std::vector<Connection> parallel = {{0, 1}, {1, 0}, {1, 2}};
+    const CycleAnalysis doubled = AnalyzeCycles(components, parallel);
+    assert(doubled.loopedComponents == std::unordered_set<int>({0, 1}));
+    assert(doubled.bridges == std::vector<size_t>({2}));
+    assert(doubled.articulationPoints == std::vector<int>({1}));
+    assert(IsCircuitLooped(components, parallel));
+
+    const std::vector<Connection> selfLoop = {{0, 1}, {2, 2}};
+    const CycleAnalysis single = AnalyzeCycles(components, selfLoop);
+    assert(single.loopedComponents == std::unordered_set<int>({2}));
+    assert(single.bridges == std::vector<size_t>({0}));
+    assert(single.articulationPoints.empty());
+
+    const std::vector<Connection> dangling = {{0, 1}, {1, 7}, {7, 0}};
+    assert(AnalyzeCycles(components, dangling).loopedComponents.empty());
+    assert(!IsCircuitLooped(components, dangling));
+}
+
+/// Checks bridges, articulation points and looped components against a
+/// remove-and-recount scan on random multigraphs.
+void TestCycleAnalysis()
+{
+    std::mt19937 rng(7);
+    for (int trial = 0; trial < 3000; ++trial) {
+        const int n = 1 + static_cast<int>(rng() % 15);
+        std::vector<Component> components(static_cast<size_t>(n));
+        for (int row = 0; row < n; ++row) {
+            components[static_cast<size_t>(row)].id = row;
+        }
+
+        std::vector<Connection> connections;
+        std::vector<std::pair<int, int>> edges;
+        const int connectionCount = static_cast<int>(rng() % static_cast<unsigned>(2 * n + 1));
+        for (int e = 0; e < connectionCount; ++e) {
+            const int a = static_cast<int>(rng() % static_cast<unsigned>(n));
+            const int b = static_cast<int>(rng() % static_cast<unsigned>(n));
+            if (a == b && rng() % 5 != 0) {
+                continue;
+            }
+            connections.push_back({a, b});
+            edges.push_back({a, b});
+        }
 
-    return inCycle;
+        const int basePieces = CountPieces(n, edges, -1, -1);
+        std::set<size_t> bridges;
+        std::unordered_set<int> looped;
+        for (size_t e = 0; e < edges.size(); ++e) {
+            if (edges[e].first != edges[e].second &&
+                CountPieces(n, edges, static_cast<int>(e), -1) > basePieces) {
+                bridges.insert(e);
+            } else {
+                looped.insert(edges[e].first);
+                looped.insert(edges[e].second);
+            }
+        }
+        std::set<int> articulationPoints;
+        for (int row = 0; row < n; ++row) {
+            bool isolated = true;
+            for (const auto& edge : edges) {
+                if ((edge.first == row || edge.second == row) && edge.first != edge.second) {
+                    isolated = false;
+                }
+            }
+            // Dropping an isolated row removes its piece; any other row must leave the count alone.
+            if (CountPieces(n, edges, -1, row) > (isolated ? basePieces - 1 : basePieces)) {
+                articulationPoints.insert(row);
+            }
+        }
+
+        const CycleAnalysis analysis = AnalyzeCycles(components, connections);
+        assert(std::set<size_t>(analysis.bridges.begin(), analysis.bridges.end()) == bridges);
+        assert(analysis.loopedComponents == looped);
+        assert(std::set<int>(analysis.articulationPoints.begin(), analysis.articulationPoints.end()) ==
+               articulationPoints);
+        assert(IsCircuitLooped(components, connections) == !looped.empty());
+    }
+    std::cerr << "[Elec3D] AnalyzeCycles: matches brute force\n";
 }
+
+#endif
@@ -1,14 +1,20 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "ComponentStore.h"
+#include "ComponentType.h"
+#include "Connectivity.h"
+
 /// Stores the editable data for one circuit component.
 struct Component {
     int id;
-    std::string type;
+    ComponentType type;
     float x,y,z;
     int layer;
 
@@ -25,6 +31,125 @@ struct Connection {
     int to_id;
 };
 
+/// Identifies a directed connection by its endpoint IDs in per-connection
+/// maps. Each ID keeps all 32 bits, so keys never alias however large IDs get.
+using ConnectionKey = uint64_t;
+
+inline ConnectionKey MakeConnectionKey(int fromId, int toId)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(fromId)) << 32) | static_cast<uint32_t>(toId);
+}
+
+inline ConnectionKey MakeConnectionKey(const Connection& connection)
+{
+    return MakeConnectionKey(connection.from_id, connection.to_id);
+}
+
+/// Flat compressed (CSR) adjacency of the undirected connection graph.
+/// Nodes are positions in the components vector, not component IDs.
+/// Self-connections and connections to unknown IDs are kept out of the
+/// neighbor lists so traversals never need to check for them.
+struct AdjacencyCSR {
+    std::vector<int> offsets;        // node i's neighbors are [offsets[i], offsets[i + 1])
+    std::vector<int> neighbors;      // neighbor node index per entry
+    std::vector<int> edges;          // connection index per entry, parallel to neighbors
+    std::vector<int> selfLoopNodes;  // nodes with a connection to themselves
+    int connectionCount = 0;         // size of the connection list the edge indices refer to
+
+    int nodeCount() const
+    {
+        return offsets.empty() ? 0 : static_cast<int>(offsets.size()) - 1;
+    }
+};
+
+/// One bit per node for traversal bookkeeping; far denser than a hash set.
+class VisitedBitset {
+public:
+    explicit VisitedBitset(int count) : words((static_cast<size_t>(count) + 63) / 64, 0) {}
+
+    bool test(int index) const
+    {
+        return (words[static_cast<size_t>(index) >> 6] >> (index & 63)) & 1u;
+    }
+
+    void set(int index)
+    {
+        words[static_cast<size_t>(index) >> 6] |= uint64_t(1) << (index & 63);
+    }
+
+private:
+    std::vector<uint64_t> words;
+};
+
+/// Resolves component IDs to positions in a components vector. IDs are
+/// usually small and dense, so a flat table is used when it stays within a
+/// few times the component count; sparse ID sets fall back to a hash map.
+class ComponentIndex {
+public:
+    ComponentIndex() = default;
+    explicit ComponentIndex(const std::vector<Component>& components);
+
+    /// Returns the component position for id, or -1 when it is unknown.
+    int find(int id) const
+    {
+        if (!m_table.empty()) {
+            const int64_t offset = static_cast<int64_t>(id) - m_base;
+            return offset >= 0 && offset < static_cast<int64_t>(m_table.size())
+                ? m_table[static_cast<size_t>(offset)]
+                : -1;
+        }
+        const auto it = m_sparse.find(id);
+        return it == m_sparse.end() ? -1 : it->second;
+    }
+
+private:
+    int m_base = 0;
+    std::vector<int> m_table;
+    std::unordered_map<int, int> m_sparse;
+};
+
+/// Topology derived from one version of a graph's component and connection
+/// lists. Immutable once built, so graph copies can share it.
+struct CircuitTopology {
+    uint64_t version = 0;
+    size_t componentCount = 0;
+    size_t connectionCount = 0;
+    ComponentIndex index;
+    AdjacencyCSR adjacency;
+};
+
+/// Cycle structure of the undirected connection graph, found in one
+/// linear-time bridge / articulation-point pass. Parallel connections
+/// between the same two components count as a loop.
+struct CycleAnalysis {
+    std::unordered_set<int> loopedComponents;   // component IDs on at least one cycle
+    std::vector<size_t> bridges;                // indices into connections; removing one splits the graph
+    std::vector<int> articulationPoints;        // component IDs whose removal splits their subgraph
+};
+
+/// The Circuit Warning facts, read once per topology version from the
+/// incremental connectivity and handed to the warning panel and the renderer.
+/// Immutable, so holders may keep it across edits; compare topologyVersion
+/// to tell whether it still describes the graph.
+struct CircuitAnalysis {
+    uint64_t topologyVersion = 0;
+    bool hasCycle = false;           // same answer as CircuitGraph::isCircuitLooped()
+    std::vector<int> disconnected;   // component IDs not reachable from the first component
+
+private:
+    friend class CircuitGraph;
+
+    // Loop membership for this version, filled by the first
+    // CircuitGraph::cycleAnalysis() call and shared by graph copies.
+    mutable std::shared_ptr<const CycleAnalysis> m_cycles;
+};
+
+class CircuitGraph;
+
+/// Immutable view of a graph at one revision. Cheap to pass around and safe
+/// to read from any thread while the live graph keeps being edited.
+using CircuitSnapshot = std::shared_ptr<const CircuitGraph>;
+
 /// Owns circuit data and exposes adjacency-based graph queries.
 class CircuitGraph {
 public:
@@ -32,27 +157,149 @@ public:
     std::vector<Connection> connections;
 
     /// Returns component IDs that cannot be reached from the first component.
-    std::vector<int> findDisconnectedComponents() const;
+    /// Answered from incremental connectivity; the reference stays valid
+    /// until the next edit.
+    const std::vector<int>& findDisconnectedComponents() const;
 
     /// Returns true when the undirected connection graph contains any cycle.
+    /// Answered from incremental connectivity, without a graph traversal.
     bool isCircuitLooped() const;
 
     /// Returns every component ID that participates in at least one cycle.
+    /// Copied out of the memoized cycleAnalysis().
     std::unordered_set<int> findLoopedComponents() const;
 
+    /// Returns loop membership, bridges and articulation points in one pass.
+    CycleAnalysis analyzeCycles() const;
+
+    /// Returns the analysis snapshot for the current topology, taken from
+    /// incremental connectivity on the first call after a topology change.
+    /// Copies share the snapshot.
+    std::shared_ptr<const CircuitAnalysis> analysis() const;
+
+    /// Returns loop membership for the current topology. The adjacency and
+    /// the Tarjan pass behind it run only on the first call after a topology
+    /// change, so topology edits nobody asks about cost no traversal. The
+    /// reference stays valid until the next topology change.
+    const CycleAnalysis& cycleAnalysis() const;
+
+    /// Builds the flat undirected adjacency of the current connections.
+    AdjacencyCSR buildAdjacency() const;
+
+    /// Identifies the current topology. It changes whenever components or
+    /// connections are added or removed; value and position edits keep it.
+    /// Versions are unique across graphs, so equal versions mean equal topology.
+    uint64_t topologyVersion() const;
+
+    /// Drops the cached adjacency and index. Every edit that adds or removes
+    /// components or connections must call this.
+    void markTopologyChanged();
+
+    /// Records one component appended to components. Like markTopologyChanged(),
+    /// but connectivity and the component store are updated in place instead
+    /// of rebuilt.
+    void markComponentAdded();
+
+    /// Records an in-place edit of one component's position, layer, type or
+    /// electrical values. Every such edit must call this, including live UI
+    /// edits, so the component store row is rewritten.
+    void markComponentEdited(int id);
+
+    /// Records one connection appended to connections, updating connectivity
+    /// in place.
+    void markConnectionAdded();
+
+    /// Cached CSR adjacency for the current topology, built on first use.
+    const AdjacencyCSR& adjacency() const;
+
+    /// ID-to-position index for the current topology, built on first use.
+    /// Safe to read from worker threads once built, as long as nobody edits
+    /// the graph meanwhile.
+    const ComponentIndex& componentIndex() const;
+
+    /// Position of the component with this ID in components, or -1. Served
+    /// by the component store's ID index, which the mark*() calls keep in
+    /// step, so lookups stay O(1) across adds and edits instead of waiting
+    /// for the topology index to be rebuilt.
+    int indexOf(int id) const;
+
+    /// Component with this ID, or null. The pointer is invalidated by the
+    /// next add or remove, like any pointer into components.
+    Component* findComponent(int id);
+    const Component* findComponent(int id) const;
+
+    /// ID for the next new component, one past the largest ID the graph
+    /// has held. IDs freed by removals are never reissued, so the raw IDs
+    /// held by commands and by the selection state stay unambiguous: a
+    /// removed component's ID resolves to nothing rather than to a newcomer.
+    int nextComponentId() const;
+
+    /// Column-oriented copy of components for per-frame render and solver
+    /// loops. Row i is components[i]. Kept in step by the mark*() calls and
+    /// rebuilt after removals; components stays the editable view.
+    const ComponentStore& componentStore() const;
+
+    /// Changes whenever any component is added, removed or edited. Unique
+    /// across graphs, like topologyVersion().
+    uint64_t componentRevision() const;
+
+    /// Snapshot of the current state. Repeated calls share one copy until
+    /// the next recorded edit, so per-frame consumers copy nothing while the
+    /// board is unchanged. Its caches are built before it is returned, so
+    /// concurrent const queries on it never write.
+    CircuitSnapshot snapshot() const;
+
 private:
-    /// Builds an undirected adjacency list from the current connections.
-    std::unordered_map<int, std::vector<int>> buildAdjacency() const;
+    /// Returns the cached topology, rebuilding it when stale. A size change
+    /// without markTopologyChanged() is treated as a topology change too.
+    const CircuitTopology& topology() const;
+
+    /// Returns connectivity for the current topology, rebuilding it after
+    /// removals or unrecorded edits.
+    CircuitConnectivity& connectivity() const;
+
+    /// Returns connectivity ready for an in-place append, or null when it is
+    /// stale and the next query has to rebuild it anyway.
+    CircuitConnectivity* connectivityForAppend(uint64_t previousVersion,
+                                               size_t addedComponents,
+                                               size_t addedConnections);
+
+    /// Starts a new topology version without touching component data.
+    void bumpTopologyVersion();
+
+    /// Returns the store ready for an in-place row change, or null when it
+    /// is stale and the next query has to rebuild it anyway.
+    ComponentStore* componentStoreForEdit(uint64_t previousRevision, size_t addedComponents);
+
+    // Copies share the cache; markTopologyChanged() detaches only this graph.
+    mutable std::shared_ptr<const CircuitTopology> m_topology;
+    mutable std::shared_ptr<CircuitConnectivity> m_connectivity;
+    mutable std::shared_ptr<const CircuitAnalysis> m_analysis;
+    mutable std::shared_ptr<ComponentStore> m_store;
+    mutable CircuitSnapshot m_snapshot;
+    mutable uint64_t m_topologyVersion = NextTopologyVersion();
+    mutable uint64_t m_componentRevision = NextTopologyVersion();
+
+    // One counter serves topology versions and component revisions alike.
+    static uint64_t NextTopologyVersion();
 };
 
+/// Builds the flat undirected adjacency in two linear passes.
+AdjacencyCSR BuildAdjacencyCSR(const std::vector<Component>& components,
+                               const std::vector<Connection>& connections);
+
+/// Same, reusing an ID index already built for components.
+AdjacencyCSR BuildAdjacencyCSR(const std::vector<Component>& components,
+                               const std::vector<Connection>& connections,
+                               const ComponentIndex& index);
+
 /// Returns component IDs that cannot be reached from the first component.
 std::vector<int> FindDisconnectedComponents(const std::vector<Component>& components,
                                             const std::vector<Connection>& connections);
 
-/// Returns true when a DFS finds a non-parent edge in the undirected graph.
-bool HasCycleDFS(int node, int parent,
-                 const std::unordered_map<int, std::vector<int>>& adj,
-                 std::unordered_set<int>& visited);
+/// Same query over an adjacency that was already built for components.
+std::vector<int> FindDisconnectedComponents(const std::vector<Component>& components,
+                                            const AdjacencyCSR& adjacency);
 
 /// Returns true when the undirected circuit graph contains any cycle.
 bool IsCircuitLooped(const std::vector<Component>& components,
@@ -61,3 +308,13 @@ bool IsCircuitLooped(const std::vector<Component>& components,
 /// Returns every component ID that participates in at least one cycle.
 std::unordered_set<int> FindLoopedComponents(const std::vector<Component>& components,
                                              const std::vector<Connection>& connections);
+
+/// Finds cycle membership, bridges and articulation points with Tarjan's
+/// low-link DFS in O(components + connections). Connections whose endpoints
+/// are not in components are ignored.
+CycleAnalysis AnalyzeCycles(const std::vector<Component>& components,
+                            const std::vector<Connection>& connections);
+
+/// Same analysis over an adjacency that was already built for components.
+CycleAnalysis AnalyzeCycles(const std::vector<Component>& components,
+                            const AdjacencyCSR& adjacency);
@@ -0,0 +1,247 @@
+#include "ComponentStore.h"
+
+#include "Circuit.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+// The edit log holds at most this many entries or two per row, whichever
+// is more; past that a consumer is better off checking every row.
+constexpr size_t EDIT_LOG_MIN_CAPACITY = 256;
+} // namespace
+
+void ComponentStore::assign(const std::vector<Component>& components)
+{
+    const size_t n = components.size();
+    m_ids.resize(n);
+    m_render.x.resize(n);
+    m_render.y.resize(n);
+    m_render.z.resize(n);
+    m_render.layer.resize(n);
+    m_types.resize(n);
+    m_electrical.resistance.resize(n);
+    m_electrical.voltage.resize(n);
+    m_electrical.capacitance.resize(n);
+    m_electrical.inductance.resize(n);
+    m_electrical.voltageSource.resize(n);
+
+    m_editLog.clear();
+    m_editLogBase = revision;
+
+    m_rowById.clear();
+    m_rowById.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        writeRow(i, components[i]);
+        claimId(components[i].id);
+        m_rowById.emplace(components[i].id, static_cast<int>(i));
+    }
+}
+
+void ComponentStore::append(const Component& component)
+{
+    const size_t index = m_ids.size();
+    m_ids.push_back(0);
+    m_render.x.push_back(0.0f);
+    m_render.y.push_back(0.0f);
+    m_render.z.push_back(0.0f);
+    m_render.layer.push_back(0);
+    m_types.push_back(ComponentType::Resistor);
+    m_electrical.resistance.push_back(0.0f);
+    m_electrical.voltage.push_back(0.0f);
+    m_electrical.capacitance.push_back(0.0f);
+    m_electrical.inductance.push_back(0.0f);
+    m_electrical.voltageSource.push_back(0.0f);
+    writeRow(index, component);
+    claimId(component.id);
+    m_rowById.emplace(component.id, static_cast<int>(index));
+
+    // Row numbers past the old end mean nothing to a consumer that has not
+    // seen this row yet, so the log starts over.
+    m_editLog.clear();
+    m_editLogBase = revision;
+}
+
+void ComponentStore::update(size_t index, const Component& component)
+{
+    writeRow(index, component);
+
+    // Drop the older half once the log outgrows the store; consumers still
+    // behind it fall back to checking every row.
+    if (m_editLog.size() >= std::max(EDIT_LOG_MIN_CAPACITY, 2 * m_ids.size())) {
+        const size_t dropped = m_editLog.size() / 2;
+        m_editLogBase = m_editLog[dropped - 1].revision;
+        m_editLog.erase(m_editLog.begin(), m_editLog.begin() + static_cast<std::ptrdiff_t>(dropped));
+    }
+    m_editLog.push_back({revision, static_cast<uint32_t>(index)});
+}
+
+bool ComponentStore::editedRowsSince(uint64_t since, std::vector<uint32_t>& rows) const
+{
+    if (since < m_editLogBase || since > revision) {
+        return false;
+    }
+    auto edit = std::upper_bound(m_editLog.begin(), m_editLog.end(), since,
+        [](uint64_t value, const RowEdit& entry) { return value < entry.revision; });
+    for (; edit != m_editLog.end(); ++edit) {
+        rows.push_back(edit->row);
+    }
+    return true;
+}
+
+int ComponentStore::indexOf(int id) const
+{
+    const auto it = m_rowById.find(id);
+    return it == m_rowById.end() ? -1 : it->second;
+}
+
+Component ComponentStore::get(size_t index) const
+{
+    Component component{};
+    component.id = m_ids[index];
+    component.type = m_types[index];
+    component.x = m_render.x[index];
+    component.y = m_render.y[index];
+    component.z = m_render.z[index];
+    component.layer = m_render.layer[index];
+    component.resistance = m_electrical.resistance[index];
+    component.voltage = m_electrical.voltage[index];
+    component.capacitance = m_electrical.capacitance[index];
+    component.inductance = m_electrical.inductance[index];
+    component.voltageSource = m_electrical.voltageSource[index];
+    return component;
+}
+
+void ComponentStore::claimId(int id)
+{
+    if (id >= m_nextId && id < std::numeric_limits<int>::max()) {
+        m_nextId = id + 1;
+    }
+}
+
+void ComponentStore::writeRow(size_t index, const Component& component)
+{
+    m_ids[index] = component.id;
+    m_render.x[index] = component.x;
+    m_render.y[index] = component.y;
+    m_render.z[index] = component.z;
+    m_render.layer[index] = component.layer;
+    m_types[index] = component.type;
+    m_electrical.resistance[index] = component.resistance;
+    m_electrical.voltage[index] = component.voltage;
+    m_electrical.capacitance[index] = component.capacitance;
+    m_electrical.inductance[index] = component.inductance;
+    m_electrical.voltageSource[index] = component.voltageSource;
+}
+
+#ifdef ELEC3D_TEST_COMPONENT_STORE
+
+#include <cassert>
+#include <iostream>
+
+namespace {
+
+std::vector<Component> MakeComponents(int count)
+{
+    std::vector<Component> components(static_cast<size_t>(count));
+    for (int id = 0; id < count; ++id) {
+        components[static_cast<size_t>(id)].id = id;
+    }
+    return components;
+}
+
+} // namespace
+
+/// The edit log answers only for revisions it fully covers: assign() and
+/// append() restart it, and an outgrown log drops its older half.
+void TestComponentStoreEditLog()
+{
+    std::vector<uint32_t> rows;
+    ComponentStore store;
+    store.revision = 10;
+    std::vector<Component> components = MakeComponents(4);
+    store.assign(components);
+    assert(store.editedRowsSince(10, rows) && rows.empty());
+    assert(!store.editedRowsSince(9, rows));
+
+    store.revision = 11;
+    components[1].x = 1.0f;
+    store.update(1, components[1]);
+    store.revision = 12;
+    components[3].x = 1.0f;
+    store.update(3, components[3]);
+    assert(store.editedRowsSince(10, rows) && rows == std::vector<uint32_t>({1, 3}));
+    rows.clear();
+    assert(store.editedRowsSince(11, rows) && rows == std::vector<uint32_t>({3}));
+    rows.clear();
+    assert(store.editedRowsSince(12, rows) && rows.empty());
+    assert(!store.editedRowsSince(13, rows));
+
+    store.revision = 13;
+    components.push_back(Component{});
+    components.back().id = 4;
+    store.append(components.back());
+    assert(!store.editedRowsSince(12, rows));
+    assert(store.editedRowsSince(13, rows) && rows.empty());
+
+    store.revision = 14;
+    store.update(0, components[0]);
+    store.revision = 15;
+    store.assign(components);
+    assert(!store.editedRowsSince(14, rows));
+    assert(store.editedRowsSince(15, rows) && rows.empty());
+
+    // 200 rows allow 400 entries, more than the 256 floor, before anything is dropped.
+    ComponentStore large;
+    large.revision = 100;
+    const std::vector<Component> many = MakeComponents(200);
+    large.assign(many);
+    for (uint32_t edit = 0; edit < 400; ++edit) {
+        large.revision = 101 + edit;
+        large.update(edit % 200, many[edit % 200]);
+    }
+    assert(large.editedRowsSince(100, rows) && rows.size() == 400);
+    rows.clear();
+
+    // The next edit drops the older 200 entries; a consumer behind them must walk every row.
+    large.revision = 501;
+    large.update(7, many[7]);
+    assert(!large.editedRowsSince(100, rows));
+    assert(!large.editedRowsSince(299, rows));
+    assert(large.editedRowsSince(300, rows) && rows.size() == 201 && rows.back() == 7);
+    rows.clear();
+    assert(large.editedRowsSince(500, rows) && rows == std::vector<uint32_t>({7}));
+    rows.clear();
+}
+
+/// A graph copy shares the store until one side edits it; the edited side
+/// gets its own store carrying the log so far, and the other keeps its own.
+void TestComponentStoreCopyOnWrite()
+{
+    CircuitGraph graph;
+    graph.components = MakeComponents(8);
+    graph.markTopologyChanged();
+    const uint64_t start = graph.componentRevision();
+    graph.components[2].x = 1.0f;
+    graph.markComponentEdited(2);
+
+    const CircuitGraph copy = graph;
+    const uint64_t copied = copy.componentRevision();
+    assert(&copy.componentStore() == &graph.componentStore());
+
+    graph.components[5].x = 1.0f;
+    graph.markComponentEdited(5);
+    assert(&copy.componentStore() != &graph.componentStore());
+
+    std::vector<uint32_t> rows;
+    assert(graph.componentStore().editedRowsSince(start, rows) && rows == std::vector<uint32_t>({2, 5}));
+    rows.clear();
+    assert(graph.componentStore().editedRowsSince(copied, rows) && rows == std::vector<uint32_t>({5}));
+    rows.clear();
+    assert(copy.componentStore().editedRowsSince(start, rows) && rows == std::vector<uint32_t>({2}));
+    assert(copy.componentRevision() == copied);
+    assert(copy.componentStore().get(5).x == 0.0f);
+    std::cerr << "[Elec3D] ComponentStore: edit log checks passed\n";
+}
+
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ComponentType.h"
+
+struct Component;
+
+/// Everything the render loop reads besides the type, one array per field.
+struct ComponentRenderColumns {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<int> layer;
+};
+
+/// Everything the solvers read, one array per field.
+struct ComponentElectricalColumns {
+    std::vector<float> resistance;
+    std::vector<float> voltage;
+    std::vector<float> capacitance;
+    std::vector<float> inductance;
+    std::vector<float> voltageSource;
+};
+
+/// Structure-of-arrays copy of a component list, split into hot render
+/// fields, hot electrical fields and cold identity, so per-frame loops
+/// stream only the bytes they use. Row i of every column describes the
+/// component at position i of the vector it was built from.
+class ComponentStore {
+public:
+    /// Component revision this copy describes; owned by CircuitGraph.
+    uint64_t revision = 0;
+
+    /// Rebuilds every column and the ID index from components, restarting
+    /// the edit log at the current revision.
+    void assign(const std::vector<Component>& components);
+
+    /// Adds a row for a component appended to the end of the source vector.
+    void append(const Component& component);
+
+    /// Rewrites row index from an edited component with the same ID and
+    /// logs the row under the current revision.
+    void update(size_t index, const Component& component);
+
+    /// Appends the rows update() rewrote after revision since, oldest first
+    /// and possibly repeated. Returns false when the store cannot tell:
+    /// rows were added or rebuilt after since, or the log no longer reaches
+    /// back that far. The caller then has to check every row.
+    bool editedRowsSince(uint64_t since, std::vector<uint32_t>& rows) const;
+
+    size_t size() const
+    {
+        return m_ids.size();
+    }
+
+    /// Cold column: component IDs, row-parallel with the hot columns.
+    const std::vector<int>& ids() const
+    {
+        return m_ids;
+    }
+
+    /// Type per row; read by both the renderer and the solvers.
+    const std::vector<ComponentType>& types() const
+    {
+        return m_types;
+    }
+
+    const ComponentRenderColumns& render() const
+    {
+        return m_render;
+    }
+
+    const ComponentElectricalColumns& electrical() const
+    {
+        return m_electrical;
+    }
+
+    /// Row of the component with this ID, or -1.
+    int indexOf(int id) const;
+
+    /// Reassembles row index as a plain Component for code that wants the
+    /// AoS view.
+    Component get(size_t index) const;
+
+    /// ID for a new component: one past the largest ID this store has ever
+    /// held. IDs of removed components are never handed out again, so an
+    /// ID kept by the UI or the undo history cannot come to mean a
+    /// different component.
+    int nextFreeId() const
+    {
+        return m_nextId;
+    }
+
+private:
+    struct RowEdit {
+        uint64_t revision = 0;
+        uint32_t row = 0;
+    };
+
+    void claimId(int id);
+    void writeRow(size_t index, const Component& component);
+
+    std::vector<int> m_ids;
+    std::vector<ComponentType> m_types;
+    ComponentRenderColumns m_render;
+    ComponentElectricalColumns m_electrical;
+
+    std::unordered_map<int, int> m_rowById;   // first component wins on duplicate IDs
+    int m_nextId = 0;                         // survives removals and rebuilds
+
+    // Rows rewritten by update(), in revision order. Complete for every
+    // revision from m_editLogBase on; assign() and append() restart it.
+    std::vector<RowEdit> m_editLog;
+    uint64_t m_editLogBase = 0;
+};
@@ -0,0 +1,102 @@
+#include "ComponentType.h"
+
+#include <array>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+const std::array<std::string, BUILTIN_COMPONENT_TYPE_COUNT> BUILTIN_NAMES = {
+    "Resistor",
+    "Capacitor",
+    "Inductor",
+    "Diode",
+    "Battery",
+};
+
+// Defaults match what the editor and the layout loader have always used.
+const std::array<ComponentTypeInfo, BUILTIN_COMPONENT_TYPE_COUNT> BUILTIN_INFO = {{
+    {{1.0f, 0.0f, 0.0f, 0.0f, 0.0f}, {1.0f, 0.5f, 0.5f}},   // Resistor
+    {{0.0f, 0.5f, 0.0f, 0.0f, 0.0f}, {0.7f, 1.0f, 0.7f}},   // Capacitor
+    {{0.0f, 0.0f, 0.8f, 0.0f, 0.0f}, {1.2f, 1.2f, 1.2f}},   // Inductor
+    {{2.0f, 0.0f, 0.0f, 0.0f, 0.0f}, {0.5f, 0.5f, 1.5f}},   // Diode
+    {{0.1f, 0.0f, 0.0f, 5.0f, 5.0f}, {1.0f, 1.0f, 1.0f}},   // Battery
+}};
+
+const ComponentTypeInfo CUSTOM_INFO{};
+const std::string OVERFLOW_NAME = "Unknown";
+
+// Custom ids run from the built-ins up to, but not including, the overflow id.
+constexpr size_t MAX_CUSTOM_TYPE_COUNT =
+    static_cast<size_t>(OVERFLOW_COMPONENT_TYPE) - BUILTIN_COMPONENT_TYPE_COUNT;
+
+/// Names outside the built-in set. A deque keeps returned references valid
+/// while later names are appended.
+struct CustomTypes {
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, ComponentType> ids;
+    bool overflowReported = false;
+};
+
+CustomTypes& customTypes()
+{
+    static CustomTypes registry;
+    return registry;
+}
+
+} // namespace
+
+ComponentType ComponentTypeFromName(const std::string& name)
+{
+    for (size_t i = 0; i < BUILTIN_NAMES.size(); ++i) {
+        if (BUILTIN_NAMES[i] == name) {
+            return static_cast<ComponentType>(i);
+        }
+    }
+
+    CustomTypes& custom = customTypes();
+    std::lock_guard<std::mutex> lock(custom.mutex);
+    const auto it = custom.ids.find(name);
+    if (it != custom.ids.end()) {
+        return it->second;
+    }
+    if (custom.names.size() >= MAX_CUSTOM_TYPE_COUNT) {
+        if (!custom.overflowReported) {
+            std::cerr << "[Elec3D] Too many custom component types; \"" << name
+                      << "\" and any later new names load as " << OVERFLOW_NAME << "\n";
+            custom.overflowReported = true;
+        }
+        return OVERFLOW_COMPONENT_TYPE;
+    }
+    const ComponentType type = static_cast<ComponentType>(BUILTIN_COMPONENT_TYPE_COUNT + custom.names.size());
+    custom.names.push_back(name);
+    custom.ids.emplace(name, type);
+    return type;
+}
+
+const std::string& ComponentTypeName(ComponentType type)
+{
+    if (IsBuiltinComponentType(type)) {
+        return BUILTIN_NAMES[static_cast<size_t>(type)];
+    }
+    if (type == OVERFLOW_COMPONENT_TYPE) {
+        return OVERFLOW_NAME;
+    }
+
+    CustomTypes& custom = customTypes();
+    std::lock_guard<std::mutex> lock(custom.mutex);
+    const size_t index = static_cast<size_t>(type) - BUILTIN_COMPONENT_TYPE_COUNT;
+    if (index < custom.names.size()) {
+        return custom.names[index];
+    }
+    static const std::string UNKNOWN_NAME;
+    return UNKNOWN_NAME;
+}
+
+const ComponentTypeInfo& ComponentTypeInfoOf(ComponentType type)
+{
+    return IsBuiltinComponentType(type) ? BUILTIN_INFO[static_cast<size_t>(type)] : CUSTOM_INFO;
+}
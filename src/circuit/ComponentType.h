@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Compact component type id. Built-in types are fixed enumerators, ordered
+/// as the editor's type combo lists them. Names read from a layout that match
+/// none of them are interned at runtime and get ids from BuiltinCount upward,
+/// so unknown types still round-trip through save/load unchanged.
+enum class ComponentType : uint16_t {
+    Resistor,
+    Capacitor,
+    Inductor,
+    Diode,
+    Battery,
+    BuiltinCount
+};
+
+constexpr size_t BUILTIN_COMPONENT_TYPE_COUNT = static_cast<size_t>(ComponentType::BuiltinCount);
+
+/// Shared by every custom name seen after the uint16_t id range has run
+/// out, so no name can wrap around onto a built-in type. Saved as
+/// "Unknown"; the names it stands for are not kept.
+constexpr ComponentType OVERFLOW_COMPONENT_TYPE = static_cast<ComponentType>(UINT16_MAX);
+
+/// Electrical values a component starts with when it is created, loaded
+/// without that field, or retyped in the editor.
+struct ComponentTypeDefaults {
+    float resistance = 1.0f;
+    float capacitance = 0.0f;
+    float inductance = 0.0f;
+    float voltageSource = 0.0f;
+    float voltage = 0.0f;
+};
+
+/// Everything the app knows about a type besides its name.
+struct ComponentTypeInfo {
+    ComponentTypeDefaults defaults;
+    float boxScale[3] = {1.0f, 1.0f, 1.0f};   // picking box / fallback cube proportions
+};
+
+inline bool IsBuiltinComponentType(ComponentType type)
+{
+    return static_cast<size_t>(type) < BUILTIN_COMPONENT_TYPE_COUNT;
+}
+
+/// Maps a serialized type name to its id, interning names it has not seen.
+/// Once the id range is used up, new names get OVERFLOW_COMPONENT_TYPE.
+/// Only the layout loader and other string boundaries should call this.
+ComponentType ComponentTypeFromName(const std::string& name);
+
+/// Serialized name of a type, for saving and display.
+const std::string& ComponentTypeName(ComponentType type);
+
+/// Registry entry for a type; interned custom types share generic defaults.
+const ComponentTypeInfo& ComponentTypeInfoOf(ComponentType type);
@@ -0,0 +1,247 @@
+#include "Connectivity.h"
+
+#include "Circuit.h"
+
+#include <utility>
+
+void CircuitConnectivity::rebuild(const std::vector<Component>& components,
+                                  const std::vector<Connection>& connections)
+{
+    m_parent.clear();
+    m_setSize.clear();
+    m_members.clear();
+    m_detachedNodes.clear();
+    m_indexById.clear();
+    m_parent.reserve(components.size());
+    m_setSize.reserve(components.size());
+    m_members.reserve(components.size());
+    m_indexById.reserve(components.size());
+    m_connectionCount = 0;
+    m_redundantConnections = 0;
+    m_danglingConnections = 0;
+    m_disconnected.clear();
+    m_disconnectedValid = false;
+
+    for (const auto& component : components) {
+        addComponent(component);
+    }
+    for (const auto& connection : connections) {
+        addConnection(connection);
+    }
+}
+
+bool CircuitConnectivity::addComponent(const Component& component)
+{
+    const int node = static_cast<int>(m_parent.size());
+    m_parent.push_back(node);
+    m_setSize.push_back(1);
+    if (node == 0) {
+        m_members.emplace_back();
+    } else {
+        m_members.push_back({node});
+        m_detachedNodes.insert(m_detachedNodes.end(), node);
+    }
+    const bool isNewId = m_indexById.emplace(component.id, node).second;
+
+    // A new node starts alone, so it is disconnected unless it is the first.
+    if (m_disconnectedValid && node > 0) {
+        m_disconnected.push_back(component.id);
+    }
+    if (node == 0) {
+        m_disconnectedValid = true;
+    }
+
+    return !(isNewId && m_danglingConnections > 0);
+}
+
+void CircuitConnectivity::addConnection(const Connection& connection)
+{
+    ++m_connectionCount;
+
+    const auto from = m_indexById.find(connection.from_id);
+    const auto to = m_indexById.find(connection.to_id);
+    if (from == m_indexById.end() || to == m_indexById.end()) {
+        ++m_danglingConnections;
+        return;
+    }
+
+    unite(from->second, to->second);
+}
+
+const std::vector<int>& CircuitConnectivity::disconnected(const std::vector<Component>& components)
+{
+    if (m_disconnectedValid) {
+        return m_disconnected;
+    }
+
+    m_disconnected.clear();
+    m_disconnected.reserve(m_detachedNodes.size());
+    for (int node : m_detachedNodes) {
+        m_disconnected.push_back(components[static_cast<size_t>(node)].id);
+    }
+    m_disconnectedValid = true;
+    return m_disconnected;
+}
+
+int CircuitConnectivity::findRoot(int node)
+{
+    // Path halving: every other node on the way up skips to its grandparent.
+    while (m_parent[static_cast<size_t>(node)] != node) {
+        int& parent = m_parent[static_cast<size_t>(node)];
+        parent = m_parent[static_cast<size_t>(parent)];
+        node = parent;
+    }
+    return node;
+}
+
+void CircuitConnectivity::unite(int a, int b)
+{
+    int rootA = findRoot(a);
+    int rootB = findRoot(b);
+    if (rootA == rootB) {
+        // Self-connections land here too, matching AnalyzeCycles.
+        ++m_redundantConnections;
+        return;
+    }
+
+    // Joining the first component's set attaches every member of the other
+    // set. Each node is attached at most once between rebuilds.
+    const int origin = findRoot(0);
+    if (rootA == origin || rootB == origin) {
+        std::vector<int>& attached = m_members[static_cast<size_t>(rootA == origin ? rootB : rootA)];
+        for (int node : attached) {
+            m_detachedNodes.erase(node);
+        }
+        std::vector<int>().swap(attached);
+        m_disconnectedValid = false;
+    }
+
+    if (m_setSize[static_cast<size_t>(rootA)] < m_setSize[static_cast<size_t>(rootB)]) {
+        std::swap(rootA, rootB);
+    }
+    m_parent[static_cast<size_t>(rootB)] = rootA;
+    m_setSize[static_cast<size_t>(rootA)] += m_setSize[static_cast<size_t>(rootB)];
+
+    // Between two detached sets the smaller member list moves into the
+    // larger one, so a node is copied O(log n) times in total.
+    std::vector<int>& absorbed = m_members[static_cast<size_t>(rootB)];
+    std::vector<int>& kept = m_members[static_cast<size_t>(rootA)];
+    kept.insert(kept.end(), absorbed.begin(), absorbed.end());
+    std::vector<int>().swap(absorbed);
+}
+
+#ifdef ELEC3D_TEST_CONNECTIVITY
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+
+namespace {
+
+void AppendComponent(CircuitGraph& graph, int id)
+{
+    Component component{};
+    component.id = id;
+    component.type = ComponentType::Resistor;
+    graph.components.push_back(component);
+    graph.markComponentAdded();
+}
+
+void AppendConnection(CircuitGraph& graph, int fromId, int toId)
+{
+    graph.connections.push_back({fromId, toId});
+    graph.markConnectionAdded();
+}
+
+void DeleteComponent(CircuitGraph& graph, int id)
+{
+    graph.components.erase(std::find_if(graph.components.begin(), graph.components.end(),
+        [id](const Component& c) { return c.id == id; }));
+    graph.connections.erase(std::remove_if(graph.connections.begin(), graph.connections.end(),
+        [id](const Connection& c) { return c.from_id == id || c.to_id == id; }), graph.connections.end());
+    graph.markTopologyChanged();
+}
+
+bool MatchesFullScan(const CircuitGraph& graph)
+{
+    return graph.findDisconnectedComponents() == FindDisconnectedComponents(graph.components, graph.connections)
+        && graph.isCircuitLooped() == IsCircuitLooped(graph.components, graph.connections);
+}
+
+} // namespace
+
+/// Walks the incremental paths one at a time: detached sets merging before
+/// they reach the first component, a dangling connection whose ID appears
+/// later, and a delete that forces a rebuild.
+void TestCircuitConnectivityCases()
+{
+    CircuitGraph graph;
+    for (int id = 0; id < 5; ++id) {
+        AppendComponent(graph, id);
+    }
+    AppendConnection(graph, 1, 2);
+    AppendConnection(graph, 3, 4);
+    AppendConnection(graph, 2, 3);
+    assert(graph.findDisconnectedComponents() == std::vector<int>({1, 2, 3, 4}));
+    assert(!graph.isCircuitLooped());
+    AppendConnection(graph, 0, 4);
+    assert(graph.findDisconnectedComponents().empty());
+    AppendConnection(graph, 1, 4);
+    assert(graph.isCircuitLooped());
+
+    AppendConnection(graph, 0, 9);
+    AppendComponent(graph, 8);
+    assert(graph.findDisconnectedComponents() == std::vector<int>({8}));
+    AppendComponent(graph, 9);
+    assert(graph.findDisconnectedComponents() == std::vector<int>({8}));
+
+    DeleteComponent(graph, 3);
+    assert(graph.findDisconnectedComponents() == std::vector<int>({8}));
+    assert(!graph.isCircuitLooped());
+    DeleteComponent(graph, 0);
+    assert(MatchesFullScan(graph));
+}
+
+/// Random add, connect, delete and dangling-connection sequences must give
+/// the same answers as a full scan after every step, on the graph and on
+/// copies taken along the way.
+void TestCircuitConnectivity()
+{
+    std::mt19937 rng(7);
+    for (int trial = 0; trial < 300; ++trial) {
+        CircuitGraph graph;
+        std::vector<CircuitGraph> copies;
+        int nextId = 0;
+        for (int step = 0; step < 80; ++step) {
+            const unsigned op = rng() % 10;
+            if (op < 3 || graph.components.empty()) {
+                // Sometimes reuse an ID, or bring in one a dangling connection already names.
+                const unsigned pick = rng() % 6;
+                const int id = pick == 0 ? static_cast<int>(rng() % static_cast<unsigned>(nextId + 1))
+                             : pick == 1 ? nextId + 1 + static_cast<int>(rng() % 3)
+                                         : nextId;
+                nextId = std::max(nextId, id + 1);
+                AppendComponent(graph, id);
+            } else if (op < 8) {
+                const int fromId = graph.components[rng() % graph.components.size()].id;
+                const int toId = rng() % 8 == 0 ? nextId + static_cast<int>(rng() % 3)
+                               : graph.components[rng() % graph.components.size()].id;
+                AppendConnection(graph, fromId, toId);
+            } else {
+                DeleteComponent(graph, graph.components[rng() % graph.components.size()].id);
+            }
+
+            if (rng() % 4 == 0) {
+                copies.push_back(graph);
+            }
+            assert(MatchesFullScan(graph));
+        }
+        for (const CircuitGraph& copy : copies) {
+            assert(MatchesFullScan(copy));
+        }
+    }
+    std::cerr << "[Elec3D] CircuitConnectivity: incremental state matches a full scan\n";
+}
+
+#endif
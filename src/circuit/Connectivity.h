@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+struct Component;
+struct Connection;
+
+/// Keeps the Circuit Warning answers (which components are cut off from the
+/// first one, and whether any loop exists) current as edits arrive.
+///
+/// Nodes are positions in the components vector. Appended components and
+/// connections are merged into a union-find in near-constant amortized time.
+/// Sets other than the first component's keep member lists, merged small
+/// into large, so joining the first component's set removes exactly the
+/// newly attached nodes from the disconnected set.
+/// A union-find cannot split sets, so removals are not applied here: the
+/// owner throws the structure away and rebuilds it once on the next query,
+/// however many removals arrived in between.
+class CircuitConnectivity {
+public:
+    /// Topology version this state describes; owned by CircuitGraph.
+    uint64_t version = 0;
+
+    /// Rebuilds from scratch in O(components + connections).
+    void rebuild(const std::vector<Component>& components,
+                 const std::vector<Connection>& connections);
+
+    /// Applies a component appended to the end of the components vector.
+    /// Returns false when the structure can no longer be kept incrementally
+    /// (an earlier connection was waiting for this ID) and must be rebuilt.
+    bool addComponent(const Component& component);
+
+    /// Applies a connection appended to the end of the connections vector.
+    void addConnection(const Connection& connection);
+
+    /// True when any connection closes a loop: a self-connection, a parallel
+    /// connection, or an edge between two already-connected components.
+    bool hasCycle() const
+    {
+        return m_redundantConnections > 0;
+    }
+
+    /// Component IDs not connected to the first component, in component order.
+    /// Costs O(result size) after a change and nothing otherwise.
+    const std::vector<int>& disconnected(const std::vector<Component>& components);
+
+    size_t componentCount() const
+    {
+        return m_parent.size();
+    }
+
+    size_t connectionCount() const
+    {
+        return m_connectionCount;
+    }
+
+private:
+    int findRoot(int node);
+    void unite(int a, int b);
+
+    std::vector<int> m_parent;
+    std::vector<int> m_setSize;
+    std::vector<std::vector<int>> m_members;    // per root, empty for the first component's set
+    std::set<int> m_detachedNodes;              // nodes outside the first component's set
+    std::unordered_map<int, int> m_indexById;   // first component wins on duplicate IDs
+    size_t m_connectionCount = 0;
+    size_t m_redundantConnections = 0;
+    size_t m_danglingConnections = 0;   // connections naming an unknown ID, ignored like BuildAdjacencyCSR does
+
+    std::vector<int> m_disconnected;
+    bool m_disconnectedValid = false;
+};
@@ -14,8 +14,7 @@ AddComponentCommand::AddComponentCommand(CircuitGraph& graph, Component componen
 void AddComponentCommand::execute()
 {
     // Duplicate IDs make selection, rendering, and solver lookup ambiguous.
-    const auto sameId = [this](const Component& c) { return c.id == m_component.id; };
-    if (std::any_of(m_graph.components.begin(), m_graph.components.end(), sameId)) {
+    if (m_graph.indexOf(m_component.id) >= 0) {
         std::cerr << "[Elec3D] AddComponentCommand failed: component "
                   << m_component.id << " already exists\n";
         return;
@@ -23,6 +22,7 @@ void AddComponentCommand::execute()
 
     // CommandHistory::push() calls execute(), so this is the only add site.
     m_graph.components.push_back(m_component);
+    m_graph.markComponentAdded();
 }
 
 void AddComponentCommand::undo()
@@ -47,4 +47,5 @@ void AddComponentCommand::undo()
                 return conn.from_id == m_component.id || conn.to_id == m_component.id;
             }),
         m_graph.connections.end());
+    m_graph.markTopologyChanged();
 }
@@ -26,16 +26,16 @@ void ChangeLayerCommand::undo()
 
 bool ChangeLayerCommand::setLayer(int layer)
 {
-    // Search by component ID because layer edits should survive vector reorder.
-    for (auto& component : m_graph.components) {
-        if (component.id == m_id) {
-            component.layer = layer;
-            return true;
-        }
+    // Look up by component ID because layer edits should survive vector reorder.
+    Component* component = m_graph.findComponent(m_id);
+    if (!component) {
+        // A missing component means the command history no longer matches the graph.
+        std::cerr << "[Elec3D] ChangeLayerCommand failed: component "
+                  << m_id << " was not found\n";
+        return false;
     }
 
-    // A missing component means the command history no longer matches the graph.
-    std::cerr << "[Elec3D] ChangeLayerCommand failed: component "
-              << m_id << " was not found\n";
-    return false;
+    component->layer = layer;
+    m_graph.markComponentEdited(m_id);
+    return true;
 }
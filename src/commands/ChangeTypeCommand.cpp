@@ -1,23 +1,22 @@
 #include "ChangeTypeCommand.h"
 
 #include <iostream>
-#include <utility>
 
 ChangeTypeCommand::ChangeTypeCommand(CircuitGraph& graph, int id,
-                                     std::string oldType, float oldResistance,
+                                     ComponentType oldType, float oldResistance,
                                      float oldCapacitance, float oldInductance,
                                      float oldVoltageSource,
-                                     std::string newType, float newResistance,
+                                     ComponentType newType, float newResistance,
                                      float newCapacitance, float newInductance,
                                      float newVoltageSource)
     : m_graph(graph),
       m_id(id),
-      m_oldType(std::move(oldType)),
+      m_oldType(oldType),
       m_oldResistance(oldResistance),
       m_oldCapacitance(oldCapacitance),
       m_oldInductance(oldInductance),
       m_oldVoltageSource(oldVoltageSource),
-      m_newType(std::move(newType)),
+      m_newType(newType),
       m_newResistance(newResistance),
       m_newCapacitance(newCapacitance),
       m_newInductance(newInductance),
@@ -40,27 +39,25 @@ void ChangeTypeCommand::undo()
                   m_oldInductance, m_oldVoltageSource);
 }
 
-bool ChangeTypeCommand::applySnapshot(const std::string& type, float resistance,
+bool ChangeTypeCommand::applySnapshot(ComponentType type, float resistance,
                                       float capacitance, float inductance,
                                       float voltageSource)
 {
     // IDs are stable across UI edits; vector indices are not.
-    for (auto& component : m_graph.components) {
-        if (component.id != m_id) {
-            continue;
-        }
-
-        // Type and defaults must change together to keep the editor coherent.
-        component.type = type;
-        component.resistance = resistance;
-        component.capacitance = capacitance;
-        component.inductance = inductance;
-        component.voltageSource = voltageSource;
-        return true;
+    Component* component = m_graph.findComponent(m_id);
+    if (!component) {
+        // Missing IDs are non-fatal, but logging exposes broken history state.
+        std::cerr << "[Elec3D] ChangeTypeCommand failed: component "
+                  << m_id << " was not found\n";
+        return false;
     }
 
-    // Missing IDs are non-fatal, but logging exposes broken history state.
-    std::cerr << "[Elec3D] ChangeTypeCommand failed: component "
-              << m_id << " was not found\n";
-    return false;
+    // Type and defaults must change together to keep the editor coherent.
+    component->type = type;
+    component->resistance = resistance;
+    component->capacitance = capacitance;
+    component->inductance = inductance;
+    component->voltageSource = voltageSource;
+    m_graph.markComponentEdited(m_id);
+    return true;
 }
@@ -20,6 +20,7 @@ void ConnectCommand::execute()
 
     // The graph owns connection order, so appending preserves current UI behavior.
     m_graph.connections.push_back(m_connection);
+    m_graph.markConnectionAdded();
 }
 
 void ConnectCommand::undo()
@@ -40,11 +41,11 @@ void ConnectCommand::undo()
 
     // Erasing the exact iterator avoids touching unrelated equal-looking commands.
     m_graph.connections.erase(it);
+    m_graph.markTopologyChanged();
 }
 
 bool ConnectCommand::componentExists(int id) const
 {
     // IDs, not vector indices, are the stable references used throughout Elec3D.
-    return std::any_of(m_graph.components.begin(), m_graph.components.end(),
-        [id](const Component& component) { return component.id == id; });
+    return m_graph.indexOf(id) >= 0;
 }
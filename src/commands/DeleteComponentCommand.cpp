@@ -12,15 +12,15 @@ DeleteComponentCommand::DeleteComponentCommand(CircuitGraph& graph, int componen
 void DeleteComponentCommand::execute()
 {
     // Find by component ID because UI IDs remain stable even if vector order changes.
-    const auto target = [this](const Component& c) { return c.id == m_componentId; };
-    auto it = std::find_if(m_graph.components.begin(), m_graph.components.end(), target);
-    if (it == m_graph.components.end()) {
+    const int index = m_graph.indexOf(m_componentId);
+    if (index < 0) {
         std::cerr << "[Elec3D] DeleteComponentCommand failed: component "
                   << m_componentId << " was not found\n";
         return;
     }
 
     // Keep the full component so undo restores all fields, not just position/type.
+    const auto it = m_graph.components.begin() + index;
     m_component = *it;
     m_connections.clear();
 
@@ -39,6 +39,7 @@ void DeleteComponentCommand::execute()
                 return conn.from_id == m_componentId || conn.to_id == m_componentId;
             }),
         m_graph.connections.end());
+    m_graph.markTopologyChanged();
 
     // Undo is only valid after execute() successfully captured state.
     m_hasSnapshot = true;
@@ -53,16 +54,18 @@ void DeleteComponentCommand::undo()
     }
 
     // Avoid creating duplicate IDs if external code already restored the component.
-    const auto sameId = [this](const Component& c) { return c.id == m_component.id; };
-    if (std::any_of(m_graph.components.begin(), m_graph.components.end(), sameId)) {
+    if (m_graph.indexOf(m_component.id) >= 0) {
         std::cerr << "[Elec3D] DeleteComponentCommand undo skipped: component "
                   << m_component.id << " already exists\n";
         return;
     }
 
     // Restore the component before connections so every endpoint exists again.
+    // Both are appends, so connectivity is extended rather than rebuilt.
     m_graph.components.push_back(m_component);
+    m_graph.markComponentAdded();
     for (const auto& conn : m_connections) {
         m_graph.connections.push_back(conn);
+        m_graph.markConnectionAdded();
     }
 }
@@ -29,35 +29,32 @@ void EditPropertyCommand::undo()
 
 bool EditPropertyCommand::setValue(float value)
 {
-    // Search by ID because component order is allowed to change after edits.
-    for (auto& component : m_graph.components) {
-        if (component.id != m_id) {
-            continue;
-        }
-
-        // Keep property names byte-stable with JSON/UI field names where possible.
-        if (m_propertyName == "resistance") {
-            component.resistance = value;
-        } else if (m_propertyName == "capacitance") {
-            component.capacitance = value;
-        } else if (m_propertyName == "inductance") {
-            component.inductance = value;
-        } else if (m_propertyName == "voltageSource") {
-            component.voltageSource = value;
-        } else if (m_propertyName == "voltage") {
-            component.voltage = value;
-        } else {
-            std::cerr << "[Elec3D] EditPropertyCommand failed: unsupported property "
-                      << m_propertyName << "\n";
-            return false;
-        }
+    // Look up by ID because component order is allowed to change after edits.
+    Component* component = m_graph.findComponent(m_id);
+    if (!component) {
+        // Missing IDs are reported instead of crashing during undo/redo.
+        std::cerr << "[Elec3D] EditPropertyCommand failed: component "
+                  << m_id << " was not found\n";
+        return false;
+    }
 
-        // Returning here proves exactly one component consumed the edit.
-        return true;
+    // Keep property names byte-stable with JSON/UI field names where possible.
+    if (m_propertyName == "resistance") {
+        component->resistance = value;
+    } else if (m_propertyName == "capacitance") {
+        component->capacitance = value;
+    } else if (m_propertyName == "inductance") {
+        component->inductance = value;
+    } else if (m_propertyName == "voltageSource") {
+        component->voltageSource = value;
+    } else if (m_propertyName == "voltage") {
+        component->voltage = value;
+    } else {
+        std::cerr << "[Elec3D] EditPropertyCommand failed: unsupported property "
+                  << m_propertyName << "\n";
+        return false;
     }
 
-    // Missing IDs are reported instead of crashing during undo/redo.
-    std::cerr << "[Elec3D] EditPropertyCommand failed: component "
-              << m_id << " was not found\n";
-    return false;
+    m_graph.markComponentEdited(m_id);
+    return true;
 }
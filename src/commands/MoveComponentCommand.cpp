@@ -27,18 +27,18 @@ void MoveComponentCommand::undo()
 bool MoveComponentCommand::setPosition(glm::vec3 position)
 {
     // IDs are stable handles; vector indices are not safe after add/delete.
-    for (auto& component : m_graph.components) {
-        if (component.id == m_id) {
-            // Position is stored as separate floats in the current Component schema.
-            component.x = position.x;
-            component.y = position.y;
-            component.z = position.z;
-            return true;
-        }
+    Component* component = m_graph.findComponent(m_id);
+    if (!component) {
+        // A missing target is non-fatal but must be visible during debugging.
+        std::cerr << "[Elec3D] MoveComponentCommand failed: component "
+                  << m_id << " was not found\n";
+        return false;
     }
 
-    // A missing target is non-fatal but must be visible during debugging.
-    std::cerr << "[Elec3D] MoveComponentCommand failed: component "
-              << m_id << " was not found\n";
-    return false;
+    // Position is stored as separate floats in the current Component schema.
+    component->x = position.x;
+    component->y = position.y;
+    component->z = position.z;
+    m_graph.markComponentEdited(m_id);
+    return true;
 }
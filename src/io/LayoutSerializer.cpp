@@ -10,21 +10,12 @@ using json = nlohmann::json;
 /// Applies type defaults only when the JSON omitted that electrical field.
 static void applyComponentDefaults(Component& component, const json& item)
 {
-    if (component.type == "Resistor") {
-        if (!item.contains("resistance")) component.resistance = 1.0f;
-    } else if (component.type == "Capacitor") {
-        if (!item.contains("capacitance")) component.capacitance = 0.5f;
-        if (!item.contains("resistance")) component.resistance = 0.0f;
-    } else if (component.type == "Inductor") {
-        if (!item.contains("inductance")) component.inductance = 0.8f;
-        if (!item.contains("resistance")) component.resistance = 0.0f;
-    } else if (component.type == "Diode") {
-        if (!item.contains("resistance")) component.resistance = 2.0f;
-    } else if (component.type == "Battery") {
-        if (!item.contains("resistance")) component.resistance = 0.1f;
-        if (!item.contains("voltageSource")) component.voltageSource = 5.0f;
-        if (!item.contains("voltage")) component.voltage = 5.0f;
-    }
+    const ComponentTypeDefaults& defaults = ComponentTypeInfoOf(component.type).defaults;
+    if (!item.contains("resistance")) component.resistance = defaults.resistance;
+    if (!item.contains("capacitance")) component.capacitance = defaults.capacitance;
+    if (!item.contains("inductance")) component.inductance = defaults.inductance;
+    if (!item.contains("voltageSource")) component.voltageSource = defaults.voltageSource;
+    if (!item.contains("voltage")) component.voltage = defaults.voltage;
 }
 
 CircuitGraph LayoutSerializer::load(const std::string& path)
@@ -43,7 +34,8 @@ CircuitGraph LayoutSerializer::load(const std::string& path)
     for (const auto& item : layout.value("components", json::array())) {
         Component c;
         c.id = item.value("id", 0);
-        c.type = item.value("type", std::string{});
+        // Type names exist only in the file; everything past this line uses ids.
+        c.type = ComponentTypeFromName(item.value("type", std::string{}));
         c.resistance = item.value("resistance", 1.0f);
         c.voltage = item.value("voltage", 0.0f);
         c.capacitance = item.value("capacitance", 0.0f);
@@ -78,7 +70,7 @@ void LayoutSerializer::save(const CircuitGraph& graph, const std::string& path)
     for (const auto& c : graph.components) {
         json compJson;
         compJson["id"] = c.id;
-        compJson["type"] = c.type;
+        compJson["type"] = ComponentTypeName(c.type);
         compJson["layer"] = c.layer;
         compJson["position"] = {c.x, c.y, c.z};
         compJson["resistance"] = c.resistance;
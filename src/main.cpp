@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include <array>
 #include <iomanip>
 #include <iostream>
 #include <nlohmann/json.hpp>
@@ -34,6 +35,7 @@
 #include "io/LayoutSerializer.h"
 #include "renderer/Camera.h"
 #include "renderer/Renderer.h"
+#include "renderer/ScenePicker.h"
 #include "sim/MNASolver.h"
 #include "sim/TransientSolver.h"
 
@@ -49,10 +51,18 @@ bool firstMouse = true;
 
 bool isDragging = false;
 bool isPanning = false;
+bool isBoxSelecting = false;     // Shift + left drag spans a selection box instead of orbiting
+bool boxSelectReleased = false;  // set on the release that ends a box; the frame loop consumes it
+double boxSelectStartX = 0.0;
+double boxSelectStartY = 0.0;
+double boxSelectEndX = 0.0;
+double boxSelectEndY = 0.0;
 Camera camera;
 
 
 bool showGrid = true;  // Toggle visibility
+bool useGpuPicking = false;  // hover and click read the ID buffer instead of casting rays
+bool gpuWireTessellation = true;  // wire tubes bent on the GPU; off tessellates them on worker threads
 
 CommandHistory commandHistory;
 bool simulationDirty = true;
@@ -152,6 +162,12 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 return;
             }
 
+            if (button == GLFW_MOUSE_BUTTON_LEFT && (mods & GLFW_MOD_SHIFT) != 0) {
+                isBoxSelecting = true;
+                glfwGetCursorPos(window, &boxSelectStartX, &boxSelectStartY);
+                return;
+            }
+
             if (button == GLFW_MOUSE_BUTTON_LEFT) {
                 isDragging = true;
             } else {
@@ -159,6 +175,11 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             }
             firstMouse = true;  // reset to prevent jump
         } else if (action == GLFW_RELEASE) {
+            if (button == GLFW_MOUSE_BUTTON_LEFT && isBoxSelecting) {
+                isBoxSelecting = false;
+                boxSelectReleased = true;
+                glfwGetCursorPos(window, &boxSelectEndX, &boxSelectEndY);
+            }
             if (button == GLFW_MOUSE_BUTTON_LEFT) {
                 isDragging = false;
             } else {
@@ -179,49 +200,30 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera.onScroll(static_cast<float>(yoffset));
 }
 
-std::unordered_map<int, std::vector<PulseTrail>> pulseTrails;
-
 std::unordered_map<int, float> componentVoltages;
+uint64_t componentVoltagesRevision = 0;  // bumped whenever componentVoltages changes; lets the renderer skip unchanged frames
 
-std::unordered_map<int, bool> signalEnabled;  // connectionKey -> toggle state
+std::unordered_map<ConnectionKey, bool> signalEnabled;  // MakeConnectionKey() -> toggle state
+uint64_t signalEnabledRevision = 0;  // bumped whenever signalEnabled changes; the wire renderer re-lists its spheres on a change
 
 int hoverComponentId = -1;  // ID of the component currently hovered over
+int hoverConnectionIndex = -1;  // index into graph.connections of the wire currently hovered over
+ConnectionKey hoverConnectionKey = 0;  // MakeConnectionKey() of that wire, to catch a stale index
 
 int selectedComponentId = -1;  // ID of component currently selected (on click)
 
-bool RayIntersectsAABB(const glm::vec3& rayOrigin, const glm::vec3& rayDir,
-    const glm::vec3& boxMin, const glm::vec3& boxMax, float& t)
-{
-    float tmin = (boxMin.x - rayOrigin.x) / rayDir.x;
-    float tmax = (boxMax.x - rayOrigin.x) / rayDir.x;
-
-    if (tmin > tmax) std::swap(tmin, tmax);
-
-    float tymin = (boxMin.y - rayOrigin.y) / rayDir.y;
-    float tymax = (boxMax.y - rayOrigin.y) / rayDir.y;
-
-    if ((tmin > tymax) || (tymin > tmax)) return false;
-
-    if (tymin > tmin) tmin = tymin;
-    if (tymax < tmax) tmax = tymax;
+std::vector<int> boxSelectedComponentIds;  // IDs of the components inside the last selection box
 
-    float tzmin = (boxMin.z - rayOrigin.z) / rayDir.z;
-    float tzmax = (boxMax.z - rayOrigin.z) / rayDir.z;
-
-    if(tzmin > tzmax) std::swap(tzmin, tzmax);
-
-    if ((tmin > tzmax) || (tzmin > tmax)) return false;
-
-    t = tmin;
-    return true; // Ray intersects AABB
-}
-
-void SimulateVoltages(const std::vector<Component>& components, const std::vector<Connection>& connections) {
+void SimulateVoltages(const CircuitGraph& graph) {
     componentVoltages.clear();  // Reset voltages
+    ++componentVoltagesRevision;
+
+    const std::vector<Component>& components = graph.components;
+    const std::vector<Connection>& connections = graph.connections;
 
     // 1. Set voltage for batteries
     for (const auto& c : components) {
-        if (c.type == "Battery") {
+        if (c.type == ComponentType::Battery) {
             componentVoltages[c.id] = c.voltage;  // Initialize voltage
         }
     }
@@ -234,12 +236,8 @@ void SimulateVoltages(const std::vector<Component>& components, const std::vecto
         updated = false;
 
         for (const auto& conn : connections) {
-            const Component* from = nullptr;
-            const Component* to = nullptr;
-            for (const auto& c : components) {
-                if (c.id == conn.from_id) from = &c;
-                if (c.id == conn.to_id) to = &c;
-            }
+            const Component* from = graph.findComponent(conn.from_id);
+            const Component* to = graph.findComponent(conn.to_id);
 
             if (!from || !to) continue;
 
@@ -258,15 +256,19 @@ void SimulateVoltages(const std::vector<Component>& components, const std::vecto
 }
 
 
-void SolveKirchhoffVoltages(const std::vector<Component>& components, const std::vector<Connection>& connections, int groundId) {
+void SolveKirchhoffVoltages(const CircuitGraph& graph, const CircuitAnalysis& analysis, int groundId) {
     componentVoltages.clear();
-    
-    auto loopedSet = FindLoopedComponents(components, connections);
+    ++componentVoltagesRevision;
+
+    const std::vector<Component>& components = graph.components;
+    const std::vector<Connection>& connections = graph.connections;
+    const auto& loopedSet = graph.cycleAnalysis().loopedComponents;
 
     int N = components.size();
 
     // === Step 0: Check for disconnected components ===
-    auto disconnected = FindDisconnectedComponents(components, connections);
+    const auto& disconnected = analysis.disconnected;
+    (void)disconnected;  // Read only by the disabled early exit below.
     // if (!disconnected.empty()) {
     //     std::cerr << "Disconnected components found: ";
     //     for (int id : disconnected) {
@@ -277,13 +279,7 @@ void SolveKirchhoffVoltages(const std::vector<Component>& components, const std:
     // }
     // the above line is used to check for disconnected components in the graph
 
-    // === Step 1: Create ID ↔ Index mappings ===
-    std::unordered_map<int, int> idToIndex;
-    std::unordered_map<int, int> indexToId;
-    for (int i = 0; i < N; ++i) {
-        idToIndex[components[i].id] = i;
-        indexToId[i] = components[i].id;
-    }
+    // === Step 1: ID -> index comes from the graph's maintained index ===
 
     // === Step 2: Build matrix A and vector b ===
     Eigen::MatrixXd A = Eigen::MatrixXd::Zero(N, N);
@@ -296,8 +292,8 @@ void SolveKirchhoffVoltages(const std::vector<Component>& components, const std:
         continue;  // skip non-loop parts
 
 
-        int i = idToIndex[conn.from_id];
-        int j = idToIndex[conn.to_id];
+        int i = graph.indexOf(conn.from_id);
+        int j = graph.indexOf(conn.to_id);
 
         float R1 = components[i].resistance;
         float R2 = components[j].resistance;
@@ -316,8 +312,8 @@ void SolveKirchhoffVoltages(const std::vector<Component>& components, const std:
 
     // === Step 4: Set known voltages from batteries ===
     for (const auto& c : components) {
-        if (c.type == "Battery" && loopedSet.count(c.id)) {
-            int idx = idToIndex[c.id];
+        if (c.type == ComponentType::Battery && loopedSet.count(c.id)) {
+            int idx = graph.indexOf(c.id);
             A.row(idx).setZero();
             A(idx, idx) = 1.0;
             b(idx) = c.voltage;
@@ -325,8 +321,8 @@ void SolveKirchhoffVoltages(const std::vector<Component>& components, const std:
     }
 
     //  === Step 5: Apply ground constraint based on user selection ===
-    if (idToIndex.count(groundId)) {
-        int groundIdx = idToIndex[groundId];
+    int groundIdx = graph.indexOf(groundId);
+    if (groundIdx >= 0) {
         A.row(groundIdx).setZero();
         A(groundIdx, groundIdx) = 1.0;
         b(groundIdx) = 0.0;
@@ -337,7 +333,7 @@ void SolveKirchhoffVoltages(const std::vector<Component>& components, const std:
 
     // === Step 7: Store voltages by original component ID ===
     for (int i = 0; i < N; ++i) {
-        int id = indexToId[i];
+        int id = components[i].id;
         componentVoltages[id] = static_cast<float>(voltages(i));
     }
 }
@@ -422,12 +418,12 @@ int main()
     }
 
     for(const auto& conn : connections){
-        int key = conn.from_id * 1000 + conn.to_id;
-        signalEnabled[key] = true;  // default to ON
+        signalEnabled[MakeConnectionKey(conn)] = true;  // default to ON
     }
+    ++signalEnabledRevision;
 
     for (const auto& c : components) {
-        std::cout << "Component " << c.id << " (" << c.type << ") at ["<< c.x << ", " << c.y << ", " << c.z << "] on layer " << c.layer << std::endl;
+        std::cout << "Component " << c.id << " (" << ComponentTypeName(c.type) << ") at ["<< c.x << ", " << c.y << ", " << c.z << "] on layer " << c.layer << std::endl;
     }
 
 
@@ -435,6 +431,7 @@ int main()
     if (!renderer.init()) {
         return -1;
     }
+    ScenePicker scenePicker;
 
     // === Auto-connect popup state ===
     static bool showConnectionPopup = false;
@@ -451,17 +448,15 @@ int main()
     // Inside render loop:
     while (!glfwWindowShouldClose(window)) {
 
-        std::vector<int> disconnectedNow = FindDisconnectedComponents(components, connections);
-        bool hasCycle = IsCircuitLooped(components, connections);
-
-        int lowestComponentId = components.empty() ? -1 : components.front().id;
-        bool groundNodeExists = false;
-        for (const auto& c : components) {
-            if (c.id < lowestComponentId) {
-                lowestComponentId = c.id;
-            }
-            if (c.id == groundComponentId) {
-                groundNodeExists = true;
+        // The ID index answers the common case; the store's ID column is
+        // scanned for a fallback only while the chosen ground is missing.
+        const bool groundNodeExists = graph.indexOf(groundComponentId) >= 0;
+        int lowestComponentId = -1;
+        if (!groundNodeExists) {
+            const std::vector<int>& componentIds = graph.componentStore().ids();
+            lowestComponentId = componentIds.empty() ? -1 : componentIds.front();
+            for (int id : componentIds) {
+                lowestComponentId = std::min(lowestComponentId, id);
             }
         }
 
@@ -472,55 +467,48 @@ int main()
             lastLoggedGroundNodeId = activeGroundNodeId;
         }
 
-        std::ostringstream circuitSignatureStream;
-        circuitSignatureStream << activeGroundNodeId;
-        for (const auto& c : components) {
-            circuitSignatureStream << "|" << c.id << ":" << c.type << ":" << c.x << ":" << c.y << ":" << c.z
-                                   << ":" << c.layer << ":" << c.resistance << ":" << c.capacitance
-                                   << ":" << c.inductance << ":" << c.voltageSource << ":" << c.voltage;
-        }
-        for (const auto& conn : connections) {
-            circuitSignatureStream << "|" << conn.from_id << ">" << conn.to_id;
-        }
-
-        static std::string lastCircuitSignature;
+        // Every edit bumps a revision, so three integers replace a per-frame
+        // string built from every component field.
+        static int lastSignatureGroundId = -1;
+        static uint64_t lastComponentRevision = 0;
+        static uint64_t lastTopologyVersion = 0;
         static bool solveFailureLogged = false;
-        const std::string circuitSignature = circuitSignatureStream.str();
-        if (circuitSignature != lastCircuitSignature) {
+        const uint64_t componentRevision = graph.componentRevision();
+        const uint64_t topologyVersion = graph.topologyVersion();
+        if (activeGroundNodeId != lastSignatureGroundId || componentRevision != lastComponentRevision
+            || topologyVersion != lastTopologyVersion) {
             solveFailureLogged = false;
-            lastCircuitSignature = circuitSignature;
+            lastSignatureGroundId = activeGroundNodeId;
+            lastComponentRevision = componentRevision;
+            lastTopologyVersion = topologyVersion;
         }
 
-        CircuitGraph simulationGraph;
-        simulationGraph.components = components;
-        simulationGraph.connections = connections;
+        // Snapshots are shared until the next edit, so an idle frame copies nothing.
+        const CircuitSnapshot simulationGraph = graph.snapshot();
 
         if (simulationDirty && activeGroundNodeId != -1) {
             std::cerr << "[Elec3D] Simulation dirty -  re-solving ("
                       << components.size() << " components)\n";
             std::ostringstream solverLogSink;
             std::streambuf* originalCerr = std::cerr.rdbuf(solverLogSink.rdbuf());
-            cachedNodeVoltages = MNASolver::solve(simulationGraph, activeGroundNodeId);
+            // Last solve's voltages seed this one; small edits then converge on the
+            // previous factorization without refactoring.
+            cachedNodeVoltages = MNASolver::solve(*simulationGraph, activeGroundNodeId, cachedNodeVoltages);
             std::cerr.rdbuf(originalCerr);
             simulationDirty = false;  // Reuse this answer until UI edits change the circuit again.
         }
 
         std::vector<float> nodeVoltages = cachedNodeVoltages;
 
-        int maxComponentId = -1;
-        for (const auto& c : components) {
-            if (c.id > maxComponentId) {
-                maxComponentId = c.id;
-            }
-        }
-        if (nodeVoltages.empty() && maxComponentId >= 0) {
+        // Voltages are indexed by position in components, not by ID.
+        if (nodeVoltages.empty() && !components.empty()) {
             if (!solveFailureLogged) {
                 std::cerr << "[Elec3D] Voltage solve failed -  circuit may be disconnected\n";
                 solveFailureLogged = true;
             }
-            nodeVoltages.assign(static_cast<size_t>(maxComponentId + 1), 0.0f);
-        } else if (maxComponentId >= 0 && maxComponentId >= static_cast<int>(nodeVoltages.size())) {
-            nodeVoltages.resize(static_cast<size_t>(maxComponentId + 1), 0.0f);
+            nodeVoltages.assign(components.size(), 0.0f);
+        } else if (components.size() > nodeVoltages.size()) {
+            nodeVoltages.resize(components.size(), 0.0f);
         }
 
         static bool firstVoltageSolveLogged = false;
@@ -537,19 +525,30 @@ int main()
             }
         }
 
-        componentVoltages.clear();
-        for (const auto& c : components) {
-            float voltage = 0.0f;
-            if (c.id >= 0 && c.id < static_cast<int>(nodeVoltages.size())) {
-                voltage = nodeVoltages[static_cast<size_t>(c.id)];
+        // Entries are overwritten in place so the revision only moves when a
+        // value actually changed; the renderer re-colors nothing otherwise.
+        bool voltagesChanged = false;
+        if (componentVoltages.size() != components.size()) {
+            componentVoltages.clear();
+            voltagesChanged = true;
+        }
+        for (size_t node = 0; node < components.size(); ++node) {
+            const Component& c = components[node];
+            const float voltage = nodeVoltages[node];
+
+            const auto [entry, inserted] = componentVoltages.try_emplace(c.id, voltage);
+            if (inserted || entry->second != voltage) {
+                entry->second = voltage;
+                voltagesChanged = true;
             }
-
-            componentVoltages[c.id] = voltage;
             voltageHistory[c.id].push_back(voltage);
             if (voltageHistory[c.id].size() > 120) {
                 voltageHistory[c.id].pop_front();
             }
         }
+        if (voltagesChanged) {
+            ++componentVoltagesRevision;
+        }
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -574,36 +573,53 @@ int main()
         const bool imguiWantsMouse =
             ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureMouse;
 
-        hoverComponentId = -1;  // Reset hover ID
-        float closestT = 1e6;  // Initialize to a large value
-
-        // Skip raycasting while the cursor is over an ImGui panel so hover/tooltip
-        // never reports a component "underneath" UI that's actually on top of it.
-        if (!imguiWantsMouse) {
-            for (const auto& c:components)
-            {
-                if (visibleLayers.count(c.layer) == 0) continue;  // Skip invisible layers
-
-                glm::vec3 pos(c.x, c.y + c.layer * 1.0f, c.z);
-                glm::vec3 scale(1.0f);
+        // One analysis per topology version, shared with drawing and the warning panel below.
+        const std::shared_ptr<const CircuitAnalysis> frameAnalysis = graph.analysis();
 
-                if (c.type == "Resistor")    scale = glm::vec3(1.0f, 0.5f, 0.5f);
-                else if (c.type == "Capacitor") scale = glm::vec3(0.7f, 1.0f, 0.7f);
-                else if (c.type == "Inductor")  scale = glm::vec3(1.2f, 1.2f, 1.2f);
-                else if (c.type == "Diode")     scale = glm::vec3(0.5f, 0.5f, 1.5f);
+        hoverComponentId = -1;  // Reset hover ID
+        hoverConnectionIndex = -1;
+        hoverConnectionKey = 0;
 
-                glm::vec3 halfExtents = scale * 0.5f;  // Half extents for AABB
-                glm::vec3 boxMin = pos - halfExtents;
-                glm::vec3 boxMax = pos + halfExtents;
+        // The ID buffer is addressed in framebuffer pixels, the cursor in window coordinates.
+        int windowWidth = 0;
+        int windowHeight = 0;
+        glfwGetWindowSize(window, &windowWidth, &windowHeight);
+        const double pixelScaleX = windowWidth > 0 ? static_cast<double>(screenWidth) / windowWidth : 1.0;
+        const double pixelScaleY = windowHeight > 0 ? static_cast<double>(screenHeight) / windowHeight : 1.0;
 
-                float t;
-                if (RayIntersectsAABB(rayOrigin, rayDir, boxMin, boxMax, t)) {
-                    if (t < closestT) {
-                        closestT = t;
-                        hoverComponentId = c.id;  // Store the ID of the hovered component
-                    }
-                }
+        // Skip picking while the cursor is over an ImGui panel so hover/tooltip
+        // never reports a component "underneath" UI that's actually on top of it.
+        // ID buffer picks land a frame or two after they are asked for; the
+        // last hover stands until a newer one arrives, but not across a
+        // topology change, which can remove what it names.
+        static GpuPickResult gpuHover;
+        static uint64_t gpuHoverTopologyVersion = 0;
+        if (!useGpuPicking || gpuHoverTopologyVersion != graph.topologyVersion()) {
+            gpuHover = GpuPickResult{};
+            gpuHoverTopologyVersion = graph.topologyVersion();
+        }
+        GpuPickResult pick;
+        while (renderer.pollPick(graph, pick)) {
+            if (pick.kind == PickKind::Box) {
+                boxSelectedComponentIds = pick.componentIds;
+            } else if (pick.kind == PickKind::Click) {
+                selectedComponentId = pick.componentId;
+            } else if (useGpuPicking) {
+                gpuHover = pick;
+            }
+        }
+        if (useGpuPicking) {
+            if (!imguiWantsMouse) {
+                renderer.requestHoverPick(static_cast<int>(mouseX * pixelScaleX), static_cast<int>(mouseY * pixelScaleY));
+                hoverComponentId = gpuHover.componentId;
+                hoverConnectionIndex = gpuHover.connectionIndex;
+                hoverConnectionKey = gpuHover.connectionKey;
             }
+        } else if (!imguiWantsMouse) {
+            const PickHit& hit = scenePicker.pick(graph, graph.cycleAnalysis().loopedComponents, visibleLayers, rayOrigin, rayDir);
+            hoverComponentId = hit.componentId;
+            hoverConnectionIndex = hit.connectionIndex;
+            hoverConnectionKey = hit.connectionKey;
         }
 
         // === CLICK SELECTION ===
@@ -616,20 +632,32 @@ int main()
             wasPressOverImGui = imguiWantsMouse;
         }
 
-        if (!isMouseDown && wasMouseDown && !imguiWantsMouse && !wasPressOverImGui) {
-            selectedComponentId = hoverComponentId;
+        if (!isMouseDown && wasMouseDown && !imguiWantsMouse && !wasPressOverImGui && !boxSelectReleased) {
+            if (useGpuPicking) {
+                // The hover answer may be frames old; read the pixels under the release instead.
+                renderer.requestClickPick(static_cast<int>(mouseX * pixelScaleX), static_cast<int>(mouseY * pixelScaleY));
+            } else {
+                selectedComponentId = hoverComponentId;
+            }
         }
         if (!isMouseDown && wasMouseDown) {
             wasPressOverImGui = false;
         }
 
         wasMouseDown = isMouseDown;
+
+        // === BOX SELECTION ===
+        // The whole box comes back in one readback, however many components it covers.
+        if (boxSelectReleased) {
+            boxSelectReleased = false;
+            renderer.requestBoxPick(
+                static_cast<int>(boxSelectStartX * pixelScaleX), static_cast<int>(boxSelectStartY * pixelScaleY),
+                static_cast<int>(boxSelectEndX * pixelScaleX), static_cast<int>(boxSelectEndY * pixelScaleY));
+        }
         
 
-        CircuitGraph renderGraph;
-        renderGraph.components = components;
-        renderGraph.connections = connections;
-        renderer.draw(renderGraph, camera, aspectRatio, static_cast<float>(glfwGetTime()));
+        const CircuitSnapshot renderGraph = graph.snapshot();
+        renderer.draw(*renderGraph, *frameAnalysis, camera, aspectRatio, static_cast<float>(glfwGetTime()));
 
         glDisable(GL_DEPTH_TEST); // Important: Disable depth test before ImGui draw
 
@@ -655,6 +683,8 @@ int main()
             }
             ImGui::Separator();
             ImGui::Checkbox("Show Grid", &showGrid);
+            ImGui::Checkbox("GPU Picking", &useGpuPicking);
+            ImGui::Checkbox("GPU Wire Tessellation", &gpuWireTessellation);
             ImGui::EndTabItem();
         }
 
@@ -676,10 +706,10 @@ int main()
         
         int selectedId = watchedComponentId;
         float currentV = 0.0f;
-        if (!nodeVoltages.empty() &&
-            selectedId >= 0 &&
-            selectedId < (int)nodeVoltages.size())
-            currentV = nodeVoltages[selectedId];
+        // nodeVoltages follows row order in graph.components, not IDs.
+        const int watchedIndex = selectedId >= 0 ? graph.indexOf(selectedId) : -1;
+        if (watchedIndex >= 0 && watchedIndex < static_cast<int>(nodeVoltages.size()))
+            currentV = nodeVoltages[static_cast<size_t>(watchedIndex)];
 
         ImGui::Text("Node %d: %.3f V", selectedId, currentV);
 
@@ -707,14 +737,7 @@ int main()
                                1e-3f, 0.1f, "%.3f");
 
             if (!components.empty()) {
-                bool nodeExists = false;
-                for (const auto& c : components) {
-                    if (c.id == transientNode) {
-                        nodeExists = true;
-                        break;
-                    }
-                }
-                if (!nodeExists) {
+                if (graph.indexOf(transientNode) < 0) {
                     transientNode = components.front().id;
                 }
 
@@ -733,11 +756,9 @@ int main()
             }
 
             if (ImGui::Button("Run Transient")) {
-                CircuitGraph transientGraph;
-                transientGraph.components = components;
-                transientGraph.connections = connections;
+                const CircuitSnapshot transientGraph = graph.snapshot();
                 transientResult = TransientSolver::solve(
-                    transientGraph, activeGroundNodeId,
+                    *transientGraph, activeGroundNodeId,
                     transientDt, transientTotal, transientNode);
             }
 
@@ -754,7 +775,15 @@ int main()
 
         // Now we will do component type selection in the UI
         static int selectedType = 0;
-        const char* componentTypes[] = { "Resistor", "Capacitor", "Inductor", "Diode" };
+        // Labels come from the type registry, so combo index i is ComponentType i.
+        static const std::array<const char*, BUILTIN_COMPONENT_TYPE_COUNT> typeLabels = [] {
+            std::array<const char*, BUILTIN_COMPONENT_TYPE_COUNT> labels{};
+            for (size_t i = 0; i < labels.size(); ++i) {
+                labels[i] = ComponentTypeName(static_cast<ComponentType>(i)).c_str();
+            }
+            return labels;
+        }();
+        constexpr int ADDABLE_TYPE_COUNT = static_cast<int>(ComponentType::Battery);  // Add menu stops before Battery.
         static int newLayer = 1; // Default to layer 1
         static float newX = 0.0f, newY = 0.0f, newz = 0.0f;
 
@@ -777,7 +806,7 @@ int main()
 
         if (ImGui::BeginTabItem("Add Component")) {
         ImGui::Text("Select Component Type:");
-        ImGui::Combo("##Type", &selectedType, componentTypes, IM_ARRAYSIZE(componentTypes));
+        ImGui::Combo("##Type", &selectedType, typeLabels.data(), ADDABLE_TYPE_COUNT);
         
         
         // Auto-connect options
@@ -796,8 +825,8 @@ int main()
         if (ImGui::Button("Add Component")) 
         {
             Component newComp;
-            newComp.id = static_cast<int>(components.size()); // Simple ID assignment
-            newComp.type = componentTypes[selectedType];
+            newComp.id = graph.nextComponentId();  // Never collides after deletes
+            newComp.type = static_cast<ComponentType>(selectedType);
             newComp.layer = newLayer;
             newComp.x = newX;
             newComp.y = newY;
@@ -833,7 +862,6 @@ int main()
                 // Store the edge as a command so Ctrl+Z removes only this auto-link.
                 commandHistory.push(std::make_unique<ConnectCommand>(graph, newConnection));
                 simulationDirty = true;  // A new edge changes the conductance matrix.
-                pulseTrails[newComp.id * 1000 + nearestID].clear();
                 std::cout << "Auto-connected to nearest: " << nearestID << std::endl;
             }
         } else if (autoConnectMode == 2 && !components.empty()) 
@@ -845,7 +873,6 @@ int main()
                 // Keep this auto-link undoable as its own user-visible action.
                 commandHistory.push(std::make_unique<ConnectCommand>(graph, newConnection));
                 simulationDirty = true;  // A new edge changes the conductance matrix.
-                pulseTrails[newComp.id * 1000 + 0].clear();
                 std::cout << "Auto-connected to first component (ID 0)" << std::endl;
             }
         } 
@@ -862,7 +889,7 @@ int main()
 
             visibleLayers.insert(newLayer); // Automatically show the new layer
 
-            std::cout << "Added component " << newComp.id << " (" << newComp.type
+            std::cout << "Added component " << newComp.id << " (" << ComponentTypeName(newComp.type)
             << ") at [" << newComp.x << ", " << newComp.y << ", " << newComp.z
             << "] on layer " << newComp.layer << std::endl;
         }
@@ -890,11 +917,8 @@ int main()
                     // Find nearest
                     float minDist = std::numeric_limits<float>::max();
                     glm::vec3 pNew;
-                    for (const auto& c : components) {
-                        if (c.id == lastAddedComponentId) {
-                            pNew = glm::vec3(c.x, c.y, c.z);
-                            break;
-                        }
+                    if (const Component* added = graph.findComponent(lastAddedComponentId)) {
+                        pNew = glm::vec3(added->x, added->y, added->z);
                     }
                     for (const auto& other : components) {
                         if (other.id == lastAddedComponentId) continue;
@@ -920,7 +944,6 @@ int main()
                     // Popup-created links follow the same undo path as manual links.
                     commandHistory.push(std::make_unique<ConnectCommand>(graph, popupConnection));
                     simulationDirty = true;  // Popup connection changes circuit topology.
-                    pulseTrails[fromID * 1000 + toID].clear();
 
                     std::cout << "Auto-connected via popup: " << fromID << " - > " << toID << std::endl;
                 }
@@ -967,11 +990,12 @@ int main()
             ImGui::Separator();
             ImGui::Text("Toggle Signal Per Connection:");
             for (const auto& conn : connections) {
-                int connKey = conn.from_id * 1000 + conn.to_id;
+                const ConnectionKey connKey = MakeConnectionKey(conn);
                 std::string label = "Signal: " + std::to_string(conn.from_id) + " - > " + std::to_string(conn.to_id);
                 bool enabled = signalEnabled[connKey];
                 if (ImGui::Checkbox(label.c_str(), &enabled)) {
                     signalEnabled[connKey] = enabled;
+                    ++signalEnabledRevision;
                 }
             }
 
@@ -979,6 +1003,7 @@ int main()
                 for (auto& pair : signalEnabled) {
                     pair.second = true;  // Toggle all signals
                 }
+                ++signalEnabledRevision;
             }
 
             ImGui::SameLine();
@@ -987,6 +1012,7 @@ int main()
                 for (auto& pair : signalEnabled) {
                     pair.second = false;  // Disable all signals
                 }
+                ++signalEnabledRevision;
             }
 
 
@@ -1011,10 +1037,6 @@ int main()
                     commandHistory.push(std::make_unique<ConnectCommand>(graph, newConn));
                     simulationDirty = true;  // Manual connection changes circuit topology.
 
-                    // Ensure trail is initialized (optional)
-                    int connKey = fromID * 1000 + toID;
-                    pulseTrails[connKey].clear();
-
                     std::cout << "Connected Component " << fromID << " to " << toID << std::endl;
                 } else {
                     std::cout << "Invalid: Cannot connect a component to itself." << std::endl;
@@ -1025,10 +1047,7 @@ int main()
 
             if (ImGui :: Button ("Save Layout to Json"))
             {
-                CircuitGraph graphToSave;
-                graphToSave.components = components;
-                graphToSave.connections = connections;
-                LayoutSerializer::save(graphToSave, "output_layout.json");
+                LayoutSerializer::save(graph, "output_layout.json");
                 std::cout << "Layout saved to output_layout.json" << std::endl;
             }
 
@@ -1043,12 +1062,12 @@ int main()
                 // Clear existing components and connections
                 components.clear();
                 connections.clear();
-                pulseTrails.clear();
                 signalEnabled.clear();
                 visibleLayers.clear();
 
-                components = loadedGraph.components;
-                connections = loadedGraph.connections;
+                components = std::move(loadedGraph.components);
+                connections = std::move(loadedGraph.connections);
+                graph.markTopologyChanged();  // Cached adjacency belongs to the old layout.
                 simulationDirty = true;  // Loaded files replace the circuit being solved.
 
                 for(const auto& c: components)
@@ -1058,10 +1077,10 @@ int main()
 
                 for(const auto& conn: connections)
                 {
-                    int key = conn.from_id * 1000 + conn.to_id;
-                    signalEnabled[key] = true; // Enable signal by default
+                    signalEnabled[MakeConnectionKey(conn)] = true; // Enable signal by default
 
                 }
+                ++signalEnabledRevision;
                 std::cout << "Layout loaded from output_layout.json\n";
             }
 
@@ -1075,19 +1094,13 @@ int main()
 
         // === Tooltip for Hovered Component ===
         if (hoverComponentId != -1) {
-            const Component* hovered = nullptr;
-            for (const auto& c : components) {
-                if (c.id == hoverComponentId) {
-                    hovered = &c;
-                    break;
-                }
-            }
+            const Component* hovered = graph.findComponent(hoverComponentId);
 
             if (hovered) {
                 ImGui::SetNextWindowBgAlpha(0.8f);
                 ImGui::BeginTooltip();
                 ImGui::Text("Component ID: %d", hovered->id);
-                ImGui::Text("Type: %s", hovered->type.c_str());
+                ImGui::Text("Type: %s", ComponentTypeName(hovered->type).c_str());
                 ImGui::Text("Layer: %d", hovered->layer);
                 ImGui::Text("Position: [%.1f, %.1f, %.1f]", hovered->x, hovered->y, hovered->z);
                 
@@ -1105,58 +1118,83 @@ int main()
             }
         }
 
+        // === Selection Box ===
+        if (isBoxSelecting) {
+            ImDrawList* drawList = ImGui::GetForegroundDrawList();
+            const ImVec2 boxStart(static_cast<float>(boxSelectStartX), static_cast<float>(boxSelectStartY));
+            const ImVec2 boxEnd(static_cast<float>(mouseX), static_cast<float>(mouseY));
+            drawList->AddRectFilled(boxStart, boxEnd, IM_COL32(90, 150, 255, 40));
+            drawList->AddRect(boxStart, boxEnd, IM_COL32(90, 150, 255, 200));
+        }
 
-        if (selectedComponentId != -1) {
-            Component* selected = nullptr;
-            for (auto& c : components) {
-                if (c.id == selectedComponentId) {
-                    selected = &c;
-                    break;
+        if (!boxSelectedComponentIds.empty()) {
+            ImGui::Begin("Box Selection");
+            ImGui::Text("%d components selected", static_cast<int>(boxSelectedComponentIds.size()));
+            if (ImGui::Button("Clear Selection")) {
+                boxSelectedComponentIds.clear();
+            }
+
+            // Thousands of entries are fine: only the visible rows are built.
+            ImGui::BeginChild("BoxSelectionList", ImVec2(0, 200), true);
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(boxSelectedComponentIds.size()));
+            while (clipper.Step()) {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                    const int id = boxSelectedComponentIds[static_cast<size_t>(i)];
+                    const Component* boxed = graph.findComponent(id);
+                    const std::string label = boxed
+                        ? "Component " + std::to_string(id) + " (" + ComponentTypeName(boxed->type) + ")"
+                        : "Component " + std::to_string(id) + " (deleted)";
+                    if (ImGui::Selectable(label.c_str(), selectedComponentId == id) && boxed) {
+                        selectedComponentId = id;
+                    }
                 }
             }
+            ImGui::EndChild();
+            ImGui::End();
+        }
+
+        // === Tooltip for Hovered Wire ===
+        if (hoverConnectionIndex >= 0 && hoverConnectionIndex < static_cast<int>(graph.connections.size())
+            && MakeConnectionKey(graph.connections[hoverConnectionIndex]) == hoverConnectionKey) {
+            const Connection& hoveredWire = graph.connections[hoverConnectionIndex];
+            const auto signal = signalEnabled.find(hoverConnectionKey);
+            const bool signalOn = signal != signalEnabled.end() && signal->second;
+
+            ImGui::SetNextWindowBgAlpha(0.8f);
+            ImGui::BeginTooltip();
+            ImGui::Text("Connection: %d -> %d", hoveredWire.from_id, hoveredWire.to_id);
+            ImGui::Text("Signal: %s", signalOn ? "ON" : "OFF");
+            ImGui::EndTooltip();
+        }
+
+
+        if (selectedComponentId != -1) {
+            Component* selected = graph.findComponent(selectedComponentId);
         
             if (selected) {
                 ImGui::Begin("Edit Component");
 
 
                 
-                const char* compTypes[] = { "Resistor", "Capacitor", "Inductor", "Diode", "Battery" };
-                int currentTypeIndex = 0;
-                for (int i = 0; i < 5; ++i) {
-                    if (selected->type == compTypes[i]) {
-                        currentTypeIndex = i;
-                        break;
-                    }
-                }
-                if (ImGui::Combo("Type", &currentTypeIndex, compTypes, IM_ARRAYSIZE(compTypes))) {
-                    const std::string oldType = selected->type;
+                // Custom types loaded from a layout show as the first entry until retyped.
+                int currentTypeIndex = IsBuiltinComponentType(selected->type) ? static_cast<int>(selected->type) : 0;
+                if (ImGui::Combo("Type", &currentTypeIndex, typeLabels.data(), static_cast<int>(typeLabels.size()))) {
+                    const ComponentType oldType = selected->type;
                     const float oldResistance = selected->resistance;
                     const float oldCapacitance = selected->capacitance;
                     const float oldInductance = selected->inductance;
                     const float oldVoltageSource = selected->voltageSource;
 
-                    // Start from neutral defaults, then override only what each type needs.
-                    const std::string newType = compTypes[currentTypeIndex];
-                    float newResistance = DEFAULT_RESISTANCE;
-                    float newCapacitance = DEFAULT_CAPACITANCE;
-                    float newInductance = DEFAULT_INDUCTANCE;
-                    float newVoltageSource = DEFAULT_VOLTAGE_SOURCE;
-
-                    // These branches preserve the existing Elec3D type defaults by name.
-                    if (newType == "Capacitor") {
-                        newResistance = REACTIVE_DEFAULT_RESISTANCE;
-                        newCapacitance = CAPACITOR_DEFAULT_CAPACITANCE;
-                    } else if (newType == "Inductor") {
-                        newResistance = REACTIVE_DEFAULT_RESISTANCE;
-                        newInductance = INDUCTOR_DEFAULT_INDUCTANCE;
-                    } else if (newType == "Diode") {
-                        newResistance = DIODE_DEFAULT_RESISTANCE;
-                    } else if (newType == "Battery") {
-                        newResistance = BATTERY_DEFAULT_RESISTANCE;
-                        newVoltageSource = BATTERY_VOLTAGE_SOURCE;
-                    }
+                    // The registry owns each type's defaults; the command applies them atomically.
+                    const ComponentType newType = static_cast<ComponentType>(currentTypeIndex);
+                    const ComponentTypeDefaults& defaults = ComponentTypeInfoOf(newType).defaults;
+                    const float newResistance = defaults.resistance;
+                    const float newCapacitance = defaults.capacitance;
+                    const float newInductance = defaults.inductance;
+                    const float newVoltageSource = defaults.voltageSource;
 
-                    // One command owns both the type string and its bundled defaults.
+                    // One command owns both the type and its bundled defaults.
                     commandHistory.push(std::make_unique<ChangeTypeCommand>(
                         graph, selected->id,
                         oldType, oldResistance, oldCapacitance, oldInductance, oldVoltageSource,
@@ -1170,6 +1208,9 @@ int main()
 
                     // ImGui edits the float live, so capture the old value before typing starts.
                     ImGui::InputFloat(label, &value);
+                    if (ImGui::IsItemEdited()) {
+                        graph.markComponentEdited(selected->id);  // Live value feeds the component store.
+                    }
                     if (ImGui::IsItemActivated()) {
                         editStartValues[editKey] = value;
                     }
@@ -1183,23 +1224,23 @@ int main()
                     }
                 };
 
-                if (selected->type == "Battery") {
+                if (selected->type == ComponentType::Battery) {
                     editFloatProperty("Resistance (Ohms)", "resistance", selected->resistance);
                     editFloatProperty("Voltage Source (V)", "voltageSource", selected->voltageSource);
-                } else if (selected->type == "Resistor") {
+                } else if (selected->type == ComponentType::Resistor) {
                     editFloatProperty("Resistance (Ohms)", "resistance", selected->resistance);
-                } else if (selected->type == "Capacitor") {
+                } else if (selected->type == ComponentType::Capacitor) {
                     editFloatProperty("Capacitance (F)", "capacitance", selected->capacitance);
                     editFloatProperty("Resistance (Ohms)", "resistance", selected->resistance);
-                } else if (selected->type == "Inductor") {
+                } else if (selected->type == ComponentType::Inductor) {
                     editFloatProperty("Inductance (H)", "inductance", selected->inductance);
                     editFloatProperty("Resistance (Ohms)", "resistance", selected->resistance);
-                } else if (selected->type == "Diode") {
+                } else if (selected->type == ComponentType::Diode) {
                     editFloatProperty("Resistance (Ohms)", "resistance", selected->resistance);
                 }
 
                 // === Editable Voltage for Battery ===
-                if (selected->type == "Battery") {
+                if (selected->type == ComponentType::Battery) {
                     editFloatProperty("Voltage (V)", "voltage", selected->voltage);
                 }
         
@@ -1210,6 +1251,9 @@ int main()
                 // Capture the full position before any one axis starts changing.
                 const glm::vec3 xPositionBeforeEdit(selected->x, selected->y, selected->z);
                 ImGui::InputFloat("X", &selected->x);
+                if (ImGui::IsItemEdited()) {
+                    graph.markComponentEdited(selected->id);
+                }
                 if (ImGui::IsItemActivated()) {
                     moveStartPositions[selected->id] = xPositionBeforeEdit;
                 }
@@ -1225,6 +1269,9 @@ int main()
                 // Y uses the same command path so each completed axis edit is undoable.
                 const glm::vec3 yPositionBeforeEdit(selected->x, selected->y, selected->z);
                 ImGui::InputFloat("Y", &selected->y);
+                if (ImGui::IsItemEdited()) {
+                    graph.markComponentEdited(selected->id);
+                }
                 if (ImGui::IsItemActivated()) {
                     moveStartPositions[selected->id] = yPositionBeforeEdit;
                 }
@@ -1240,6 +1287,9 @@ int main()
                 // Z completes the position editor without introducing a separate command class.
                 const glm::vec3 zPositionBeforeEdit(selected->x, selected->y, selected->z);
                 ImGui::InputFloat("Z", &selected->z);
+                if (ImGui::IsItemEdited()) {
+                    graph.markComponentEdited(selected->id);
+                }
                 if (ImGui::IsItemActivated()) {
                     moveStartPositions[selected->id] = zPositionBeforeEdit;
                 }
@@ -1257,6 +1307,9 @@ int main()
                 // Capture the old layer before ImGui mutates the integer live.
                 const int layerBeforeEdit = selected->layer;
                 ImGui::InputInt("Layer", &selected->layer);
+                if (ImGui::IsItemEdited()) {
+                    graph.markComponentEdited(selected->id);
+                }
                 if (ImGui::IsItemActivated()) {
                     layerStartValues[selected->id] = layerBeforeEdit;
                 }
@@ -1281,7 +1334,11 @@ int main()
         }
 
 // === Circuit Validity Panel ===
-
+// Queried after this frame's edits. The snapshot is memoized per topology
+// version, so an unchanged circuit reuses the one the renderer just drew with.
+const std::shared_ptr<const CircuitAnalysis> panelAnalysis = graph.analysis();
+const std::vector<int>& disconnectedNow = panelAnalysis->disconnected;
+const bool hasCycle = panelAnalysis->hasCycle;
 
 if (!disconnectedNow.empty() || !hasCycle) {
     ImGui::SetNextWindowPos(ImVec2(10, 700), ImGuiCond_Once);
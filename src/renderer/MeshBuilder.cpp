@@ -309,13 +309,13 @@ void appendResistorBevels(Mesh& mesh)
 }
 
 /// Build one registry entry and log if GPU upload did not produce drawable handles.
-void addUploadedMesh(std::map<std::string, Mesh>& registry, const std::string& key, Mesh mesh)
+void addUploadedMesh(MeshRegistry& registry, size_t slot, Mesh mesh)
 {
     MeshBuilder::upload(mesh, true);
     if (mesh.vao == 0 || mesh.vbo == 0 || mesh.ebo == 0 || mesh.indexCount == 0) {
-        std::cerr << "[Elec3D] MeshBuilder: failed to upload: " << key << "\n";
+        std::cerr << "[Elec3D] MeshBuilder: failed to upload mesh slot " << slot << "\n";
     }
-    registry.emplace(key, std::move(mesh));
+    registry[slot] = std::move(mesh);
 }
 
 } // namespace
@@ -421,14 +421,14 @@ Mesh MeshBuilder::buildCube()
 }
 
 /// Build and upload all meshes; return registry keyed by component type string.
-std::map<std::string, Mesh> MeshBuilder::buildRegistry()
+MeshRegistry MeshBuilder::buildRegistry()
 {
-    std::map<std::string, Mesh> registry;
-    addUploadedMesh(registry, "Battery", buildBattery());
-    addUploadedMesh(registry, "Resistor", buildResistor());
-    addUploadedMesh(registry, "Capacitor", buildCapacitor());
-    addUploadedMesh(registry, "Inductor", buildInductor());
-    addUploadedMesh(registry, "Diode", buildDiode());
-    addUploadedMesh(registry, "Cube", buildCube());
+    MeshRegistry registry;
+    addUploadedMesh(registry, MeshSlotFor(ComponentType::Battery), buildBattery());
+    addUploadedMesh(registry, MeshSlotFor(ComponentType::Resistor), buildResistor());
+    addUploadedMesh(registry, MeshSlotFor(ComponentType::Capacitor), buildCapacitor());
+    addUploadedMesh(registry, MeshSlotFor(ComponentType::Inductor), buildInductor());
+    addUploadedMesh(registry, MeshSlotFor(ComponentType::Diode), buildDiode());
+    addUploadedMesh(registry, CUBE_MESH_SLOT, buildCube());
     return registry;
 }
@@ -1,12 +1,14 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <map>
-#include <string>
 #include <vector>
 
 #include <glad/glad.h>
 
+#include "../circuit/ComponentType.h"
+
 /// A GPU-ready mesh: vertex buffer, index buffer, and draw count.
 /// build*() functions below interleave {x, y, z, nx, ny, nz} (stride 6).
 /// WireRenderer's signal sphere instead uploads position-only stride-3
@@ -20,6 +22,18 @@ struct Mesh {
     GLsizei indexCount = 0;
 };
 
+/// Mesh slots are the built-in type ids followed by one fallback cube.
+constexpr size_t CUBE_MESH_SLOT = BUILTIN_COMPONENT_TYPE_COUNT;
+constexpr size_t MESH_SLOT_COUNT = CUBE_MESH_SLOT + 1;
+
+using MeshRegistry = std::array<Mesh, MESH_SLOT_COUNT>;
+
+/// Registry slot drawn for a type; interned custom types use the cube.
+inline size_t MeshSlotFor(ComponentType type)
+{
+    return IsBuiltinComponentType(type) ? static_cast<size_t>(type) : CUBE_MESH_SLOT;
+}
+
 namespace MeshBuilder {
     /// Upload CPU-side vertex and index data to GPU; fill vao/vbo/ebo.
     /// hasNormals=false binds stride-3 position-only at location 0 (the
@@ -45,6 +59,6 @@ namespace MeshBuilder {
     /// Build cube: fallback geometry for unknown component types.
     Mesh buildCube();
 
-    /// Build and upload all meshes; return registry keyed by component type string.
-    std::map<std::string, Mesh> buildRegistry();
+    /// Build and upload all meshes; return registry indexed by MeshSlotFor().
+    MeshRegistry buildRegistry();
 }
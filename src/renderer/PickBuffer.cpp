@@ -0,0 +1,163 @@
+#include "PickBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+bool PickBuffer::init()
+{
+    glGenFramebuffers(1, &m_fbo);
+    glGenTextures(1, &m_idTexture);
+    glGenRenderbuffers(1, &m_depthBuffer);
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.pbo);
+        if (slot.pbo == 0) {
+            std::cerr << "[Elec3D] PickBuffer: failed to create readback buffer\n";
+            return false;
+        }
+    }
+    if (m_fbo == 0 || m_idTexture == 0 || m_depthBuffer == 0) {
+        std::cerr << "[Elec3D] PickBuffer: failed to create framebuffer\n";
+        return false;
+    }
+
+    // Integer textures cannot be filtered; the target is only ever read
+    // back texel for texel.
+    glBindTexture(GL_TEXTURE_2D, m_idTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
+
+bool PickBuffer::resize(int width, int height)
+{
+    if (width <= 0 || height <= 0 || (width == m_width && height == m_height)) {
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+
+    glBindTexture(GL_TEXTURE_2D, m_idTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_idTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "[Elec3D] PickBuffer: framebuffer incomplete at " << width << "x" << height << "\n";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return true;
+}
+
+void PickBuffer::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_width, m_height);
+}
+
+bool PickBuffer::read(const PickRegion& region, uint64_t tag)
+{
+    Slot* free = nullptr;
+    for (Slot& slot : m_slots) {
+        if (slot.fence == nullptr) {
+            free = &slot;
+            break;
+        }
+    }
+    if (free == nullptr) {
+        return false;
+    }
+
+    const size_t bytes = static_cast<size_t>(region.width) * static_cast<size_t>(region.height) * sizeof(uint32_t);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, free->pbo);
+    if (bytes > free->capacity) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_READ);
+        free->capacity = bytes;
+    }
+
+    // With a pack buffer bound the copy lands in it on the GPU timeline;
+    // glReadPixels returns without waiting for the image to be finished.
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(region.x, region.y, region.width, region.height, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    free->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    free->sequence = m_nextSequence++;
+    free->region = region;
+    free->tag = tag;
+    return true;
+}
+
+bool PickBuffer::poll(PickReadback& readback)
+{
+    Slot* oldest = nullptr;
+    for (Slot& slot : m_slots) {
+        if (slot.fence != nullptr && (oldest == nullptr || slot.sequence < oldest->sequence)) {
+            oldest = &slot;
+        }
+    }
+    if (oldest == nullptr) {
+        return false;
+    }
+    const GLenum status = glClientWaitSync(oldest->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(oldest->fence);
+    oldest->fence = nullptr;
+
+    readback.region = oldest->region;
+    readback.tag = oldest->tag;
+    const size_t count = static_cast<size_t>(oldest->region.width) * static_cast<size_t>(oldest->region.height);
+    readback.ids.resize(count);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, oldest->pbo);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+        static_cast<GLsizeiptr>(count * sizeof(uint32_t)), GL_MAP_READ_BIT);
+    if (mapped == nullptr) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        std::cerr << "[Elec3D] PickBuffer: failed to map readback\n";
+        readback.ids.assign(count, PICK_ID_NONE);
+        return true;
+    }
+    std::memcpy(readback.ids.data(), mapped, count * sizeof(uint32_t));
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+void PickBuffer::shutdown()
+{
+    for (Slot& slot : m_slots) {
+        if (slot.fence != nullptr) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        if (slot.pbo != 0) {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+        slot.capacity = 0;
+    }
+    if (m_depthBuffer != 0) {
+        glDeleteRenderbuffers(1, &m_depthBuffer);
+        m_depthBuffer = 0;
+    }
+    if (m_idTexture != 0) {
+        glDeleteTextures(1, &m_idTexture);
+        m_idTexture = 0;
+    }
+    if (m_fbo != 0) {
+        glDeleteFramebuffers(1, &m_fbo);
+        m_fbo = 0;
+    }
+    m_width = 0;
+    m_height = 0;
+}
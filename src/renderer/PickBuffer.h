@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Values written into the ID target. 0 is background; a component writes
+// its store row + 1; a wire writes its connection index + 1 with the wire
+// bit set. component.vert and wire_tube.vert use the same encoding.
+constexpr uint32_t PICK_ID_NONE = 0u;
+constexpr uint32_t PICK_ID_WIRE_BIT = 0x80000000u;
+
+/// A rectangle of target pixels, bottom-left origin as GL addresses them.
+struct PickRegion {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+/// One region copied back from the ID target, row by row from the bottom.
+struct PickReadback {
+    PickRegion region;
+    uint64_t tag = 0;              // as passed to PickBuffer::read()
+    std::vector<uint32_t> ids;     // region.width * region.height values
+};
+
+/// Offscreen integer render target holding, per pixel, the ID of whatever
+/// was drawn nearest there, plus a ring of pixel pack buffers to read it
+/// back. A read only queues a copy on the GPU; poll() hands the pixels out
+/// once that copy's fence has passed, so the CPU never waits on the GPU.
+class PickBuffer {
+public:
+    /// Creates the framebuffer. Returns false when it could not be created.
+    bool init();
+
+    /// Matches the target to the framebuffer size. Returns true when it
+    /// reallocated, which discards every ID drawn so far.
+    bool resize(int width, int height);
+
+    /// Binds the target for drawing with a viewport covering all of it.
+    void bind();
+
+    /// Queues a copy of region, which must lie inside the target; tag comes
+    /// back with the pixels. Returns false while every slot is in flight.
+    bool read(const PickRegion& region, uint64_t tag);
+
+    /// Takes the oldest finished readback. Returns false while none has
+    /// finished.
+    bool poll(PickReadback& readback);
+
+    int width() const
+    {
+        return m_width;
+    }
+
+    int height() const
+    {
+        return m_height;
+    }
+
+    /// Frees the target, the pack buffers and any pending fences.
+    void shutdown();
+
+private:
+    static constexpr int READBACK_SLOTS = 4;   // readbacks in flight at once
+
+    struct Slot {
+        GLuint pbo = 0;
+        size_t capacity = 0;       // bytes allocated for pbo
+        GLsync fence = nullptr;    // set while the copy is in flight
+        uint64_t sequence = 0;     // issue order, to hand readbacks out oldest first
+        PickRegion region;
+        uint64_t tag = 0;
+    };
+
+    GLuint m_fbo = 0;
+    GLuint m_idTexture = 0;
+    GLuint m_depthBuffer = 0;
+    int m_width = 0;
+    int m_height = 0;
+    std::array<Slot, READBACK_SLOTS> m_slots{};
+    uint64_t m_nextSequence = 1;
+};
@@ -6,8 +6,10 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <unordered_map>
@@ -37,14 +39,73 @@ constexpr int PCB_POSITION_COMPONENT_COUNT = 3;
 constexpr int PCB_UV_COMPONENT_COUNT = 2;
 constexpr int PCB_INDEX_COUNT = 6;
 constexpr float PCB_MARGIN_SIDE_COUNT = 2.0f;
+// Pulse trail on the straight-line wire path: one head plus fading points
+// sampled at a fixed time step behind it, as the old per-frame trail looked
+// at 60 FPS.
+constexpr float PULSE_PERIOD_SECONDS = 2.0f;
+constexpr int PULSE_TRAIL_POINTS = 50;
+constexpr float PULSE_TRAIL_FADE = 1.0f / PULSE_TRAIL_POINTS;
+constexpr float PULSE_TRAIL_STEP_SECONDS = 1.0f / 60.0f;
+constexpr float PULSE_POINT_SIZE = 10.0f;
+// Per-frame region of the line/pulse stream: room for about 2700 lines and
+// their pulses before the first growth.
+constexpr size_t LINE_STREAM_REGION_BYTES = 64 * 1024;
+// Dirty instances this close together go up in one upload; re-sending a few
+// unchanged instances is cheaper than another glBufferSubData call.
+constexpr uint32_t INSTANCE_UPLOAD_MERGE_GAP = 8;
+// A hover pick reads this many pixels either side of the cursor and takes
+// the nearest drawn one, so a wire a pixel or two wide is still easy to hit.
+constexpr int PICK_HOVER_RADIUS = 3;
 }
 
 extern std::set<int> visibleLayers;
 extern bool showGrid;
-extern std::unordered_map<int, std::vector<PulseTrail>> pulseTrails;
 extern std::unordered_map<int, float> componentVoltages;
-extern std::unordered_map<int, bool> signalEnabled;
+extern std::unordered_map<ConnectionKey, bool> signalEnabled;
 extern int hoverComponentId;
+extern uint64_t componentVoltagesRevision;
+
+/// Model matrix and voltage-texture index for one component row; the
+/// instanced shader derives the color from the index.
+static InstanceData buildInstanceData(const ComponentStore& store, size_t row)
+{
+    const ComponentRenderColumns& columns = store.render();
+    const int layer = columns.layer[row];
+    const glm::vec3 pos(columns.x[row], columns.y[row] + layer * 1.0f, columns.z[row]);
+
+    InstanceData inst{};
+    inst.modelMatrix = glm::translate(glm::mat4(1.0f), pos);
+    inst.componentIndex = static_cast<int32_t>(row);
+    return inst;
+}
+
+static bool regionContains(const PickRegion& outer, const PickRegion& inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.width <= outer.x + outer.width &&
+           inner.y + inner.height <= outer.y + outer.height;
+}
+
+static bool sameRegion(const PickRegion& a, const PickRegion& b)
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+/// Smallest region covering both; an empty region covers nothing.
+static PickRegion regionUnion(const PickRegion& a, const PickRegion& b)
+{
+    if (a.width <= 0 || a.height <= 0) {
+        return b;
+    }
+    if (b.width <= 0 || b.height <= 0) {
+        return a;
+    }
+    const int x0 = std::min(a.x, b.x);
+    const int y0 = std::min(a.y, b.y);
+    const int x1 = std::max(a.x + a.width, b.x + b.width);
+    const int y1 = std::max(a.y + a.height, b.y + b.height);
+    return PickRegion{x0, y0, x1 - x0, y1 - y0};
+}
 
 /// Loads one shader source file into a string for OpenGL compilation.
 static bool loadShaderSource(const char* path, std::string& source)
@@ -168,22 +229,25 @@ bool Renderer::init()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
+    // Connection lines and pulses are rewritten every frame, so both read
+    // from the streaming ring; draw() points their attributes at the
+    // range it wrote that frame.
+    if (!m_lineStream.init(LINE_STREAM_REGION_BYTES)) {
+        return false;
+    }
     glGenVertexArrays(1, &lineVAO);
-    glGenBuffers(1, &lineVBO);
     glBindVertexArray(lineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6, nullptr, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     glBindVertexArray(0);
 
+    // Pulses have no per-vertex data: each instance is one connection, and
+    // the vertex id picks the point along its trail.
     glGenVertexArrays(1, &pulseVAO);
-    glGenBuffers(1, &pulseVBO);
     glBindVertexArray(pulseVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, pulseVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3, nullptr, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
     glBindVertexArray(0);
 
     float axisVertices[] = {
@@ -275,11 +339,18 @@ bool Renderer::init()
     m_litLightDirLoc = findUniform(m_shaderLit, "uLightDir");
     m_litViewPosLoc = findUniform(m_shaderLit, "uViewPos");
     m_litUseInstancingLoc = findUniform(m_shaderLit, "uUseInstancing");
+    m_litVoltagesLoc = findUniform(m_shaderLit, "uComponentVoltages");
+    m_litMaxVoltageLoc = findUniform(m_shaderLit, "uMaxVoltage");
+    m_litHoverIndexLoc = findUniform(m_shaderLit, "uHoverIndex");
     if (m_litModelLoc == -1 || m_litViewLoc == -1 || m_litProjLoc == -1 ||
         m_litColorLoc == -1 || m_litLightDirLoc == -1 || m_litViewPosLoc == -1 ||
-        m_litUseInstancingLoc == -1) {
+        m_litUseInstancingLoc == -1 || m_litVoltagesLoc == -1 ||
+        m_litMaxVoltageLoc == -1 || m_litHoverIndexLoc == -1) {
         return false;
     }
+    glUseProgram(m_shaderLit);
+    glUniform1i(m_litVoltagesLoc, COMPONENT_VOLTAGE_TEXTURE_UNIT);
+    glUseProgram(0);
 
     m_shaderPcb = loadShaderProgram("../shaders/pcb.vert", "../shaders/pcb.frag");
     if (m_shaderPcb == 0) {
@@ -296,6 +367,44 @@ bool Renderer::init()
         return false;
     }
 
+    m_shaderPulse = loadShaderProgram("../shaders/pulse.vert", "../shaders/pulse.frag");
+    if (m_shaderPulse == 0) {
+        return false;
+    }
+
+    m_pulseViewLoc = findUniform(m_shaderPulse, "view");
+    m_pulseProjLoc = findUniform(m_shaderPulse, "projection");
+    m_pulseColorLoc = findUniform(m_shaderPulse, "objectColor");
+    m_pulseTimeLoc = findUniform(m_shaderPulse, "uTime");
+    m_pulsePeriodLoc = findUniform(m_shaderPulse, "uPeriod");
+    m_pulseTrailStepLoc = findUniform(m_shaderPulse, "uTrailStep");
+    m_pulseTrailFadeLoc = findUniform(m_shaderPulse, "uTrailFade");
+    if (m_pulseViewLoc == -1 || m_pulseProjLoc == -1 || m_pulseColorLoc == -1 ||
+        m_pulseTimeLoc == -1 || m_pulsePeriodLoc == -1 || m_pulseTrailStepLoc == -1 ||
+        m_pulseTrailFadeLoc == -1) {
+        return false;
+    }
+
+    // Same vertex shader as the lit components, so IDs land exactly where
+    // the meshes are drawn.
+    m_shaderPick = loadShaderProgram("../shaders/component.vert", "../shaders/pick.frag");
+    if (m_shaderPick == 0) {
+        return false;
+    }
+
+    m_pickModelLoc = findUniform(m_shaderPick, "uModel");
+    m_pickViewLoc = findUniform(m_shaderPick, "uView");
+    m_pickProjLoc = findUniform(m_shaderPick, "uProjection");
+    m_pickUseInstancingLoc = findUniform(m_shaderPick, "uUseInstancing");
+    m_pickIdLoc = findUniform(m_shaderPick, "uPickId");
+    if (m_pickModelLoc == -1 || m_pickViewLoc == -1 || m_pickProjLoc == -1 ||
+        m_pickUseInstancingLoc == -1 || m_pickIdLoc == -1) {
+        return false;
+    }
+    if (!m_pickBuffer.init()) {
+        return false;
+    }
+
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
     if (USE_COMPONENT_MESHES) {
@@ -304,7 +413,8 @@ bool Renderer::init()
         // Instance VBOs attach to each mesh's EXISTING vao (built above by
         // MeshBuilder). This setup runs once regardless of
         // USE_GPU_INSTANCING so toggling the flag never needs re-init.
-        for (auto& [key, mesh] : m_meshRegistry) {
+        for (size_t slot = 0; slot < m_meshRegistry.size(); ++slot) {
+            const Mesh& mesh = m_meshRegistry[slot];
             InstanceBuffer buf;
             glGenBuffers(1, &buf.vbo);
             buf.capacity = INITIAL_INSTANCE_CAPACITY;
@@ -322,15 +432,26 @@ bool Renderer::init()
                     reinterpret_cast<void*>(offsetof(InstanceData, modelMatrix) + i * sizeof(glm::vec4)));
                 glVertexAttribDivisor(loc, 1);
             }
-            glEnableVertexAttribArray(INSTANCE_COLOR_ATTRIB_LOCATION);
-            glVertexAttribPointer(INSTANCE_COLOR_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE,
-                sizeof(InstanceData), reinterpret_cast<void*>(offsetof(InstanceData, color)));
-            glVertexAttribDivisor(INSTANCE_COLOR_ATTRIB_LOCATION, 1);
+            glEnableVertexAttribArray(INSTANCE_INDEX_ATTRIB_LOCATION);
+            glVertexAttribIPointer(INSTANCE_INDEX_ATTRIB_LOCATION, 1, GL_INT,
+                sizeof(InstanceData), reinterpret_cast<void*>(offsetof(InstanceData, componentIndex)));
+            glVertexAttribDivisor(INSTANCE_INDEX_ATTRIB_LOCATION, 1);
 
             glBindBuffer(GL_ARRAY_BUFFER, 0);
             glBindVertexArray(0);
-            m_instanceBuffers[key] = buf;
+            m_instanceBuffers[slot] = buf;
         }
+
+        glGenBuffers(1, &m_voltageBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, m_voltageBuffer);
+        m_voltageCapacity = INITIAL_INSTANCE_CAPACITY;
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(m_voltageCapacity * sizeof(float)),
+                     nullptr, GL_DYNAMIC_DRAW);
+        glGenTextures(1, &m_voltageTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, m_voltageTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, m_voltageBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
     }
     if (USE_BEZIER_WIRES) {
         if (!m_wireRenderer.init()) {
@@ -343,10 +464,10 @@ bool Renderer::init()
 
 /// Grow a mesh type's instance buffer if needed. Never shrinks; never
 /// reallocates when the existing capacity already fits the request.
-void Renderer::ensureInstanceCapacity(InstanceBuffer& buf, int neededCount)
+bool Renderer::ensureInstanceCapacity(InstanceBuffer& buf, int neededCount)
 {
     if (neededCount <= buf.capacity) {
-        return;
+        return false;
     }
     const int newCapacity = std::max(neededCount,
         buf.capacity == 0 ? INITIAL_INSTANCE_CAPACITY : buf.capacity * 2);
@@ -354,6 +475,164 @@ void Renderer::ensureInstanceCapacity(InstanceBuffer& buf, int neededCount)
     glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(newCapacity * sizeof(InstanceData)),
                  nullptr, GL_DYNAMIC_DRAW);
     buf.capacity = newCapacity;
+    return true;
+}
+
+void Renderer::removeInstance(size_t row)
+{
+    InstancePlacement& placement = m_instancePlacements[row];
+    InstanceBuffer& buf = m_instanceBuffers[placement.meshSlot];
+    const size_t index = static_cast<size_t>(placement.index);
+    const size_t last = buf.instances.size() - 1;
+    if (index != last) {
+        buf.instances[index] = buf.instances[last];
+        buf.rows[index] = buf.rows[last];
+        m_instancePlacements[static_cast<size_t>(buf.rows[index])].index = placement.index;
+        buf.dirty.push_back(static_cast<uint32_t>(index));
+    }
+    buf.instances.pop_back();
+    buf.rows.pop_back();
+    placement.index = -1;
+}
+
+void Renderer::refreshInstance(const ComponentStore& store, size_t row)
+{
+    InstancePlacement& placement = m_instancePlacements[row];
+    const bool visible = visibleLayers.count(store.render().layer[row]) > 0;
+    const size_t meshSlot = MeshSlotFor(store.types()[row]);
+    if (placement.index >= 0 && (!visible || placement.meshSlot != meshSlot)) {
+        removeInstance(row);
+    }
+    if (!visible) {
+        return;
+    }
+
+    const InstanceData inst = buildInstanceData(store, row);
+    InstanceBuffer& buf = m_instanceBuffers[meshSlot];
+    if (placement.index < 0) {
+        placement.meshSlot = static_cast<uint16_t>(meshSlot);
+        placement.index = static_cast<int>(buf.instances.size());
+        buf.instances.push_back(inst);
+        buf.rows.push_back(static_cast<int>(row));
+        buf.dirty.push_back(static_cast<uint32_t>(placement.index));
+        return;
+    }
+
+    InstanceData& current = buf.instances[static_cast<size_t>(placement.index)];
+    if (std::memcmp(&current, &inst, sizeof(InstanceData)) != 0) {
+        current = inst;
+        buf.dirty.push_back(static_cast<uint32_t>(placement.index));
+    }
+}
+
+void Renderer::syncInstances(const CircuitGraph& graph)
+{
+    const ComponentStore& store = graph.componentStore();
+    const bool storeChanged = !m_instancesValid || store.revision != m_instanceStoreRevision;
+    const bool voltagesChanged = componentVoltagesRevision != m_instanceVoltageRevision;
+    const bool layersChanged = visibleLayers != m_instanceLayers;
+    if (!storeChanged && !voltagesChanged && !layersChanged) {
+        return;
+    }
+
+    // A plain edit names its rows in the store's log; only those are
+    // refreshed. Anything the log cannot answer is checked row by row.
+    m_editedRows.clear();
+    const bool rowsEdited = storeChanged && !layersChanged && m_instancesValid &&
+        store.editedRowsSince(m_instanceStoreRevision, m_editedRows);
+    const bool rowsChanged = storeChanged && !rowsEdited && store.ids() != m_instanceIds;
+    if (rowsChanged) {
+        // Rows were added, removed or reordered: row numbers no longer line
+        // up with the placements, so every slot is laid out again.
+        for (InstanceBuffer& buf : m_instanceBuffers) {
+            buf.instances.clear();
+            buf.rows.clear();
+            buf.dirty.clear();
+        }
+        m_instancePlacements.assign(store.size(), InstancePlacement{});
+        m_instanceIds = store.ids();
+    }
+    if (rowsEdited) {
+        for (uint32_t row : m_editedRows) {
+            refreshInstance(store, row);
+        }
+    } else if (storeChanged || layersChanged) {
+        for (size_t row = 0; row < store.size(); ++row) {
+            refreshInstance(store, row);
+        }
+    }
+    if (rowsChanged || voltagesChanged) {
+        uploadVoltages(store);
+    }
+
+    m_instanceStoreRevision = store.revision;
+    m_instanceVoltageRevision = componentVoltagesRevision;
+    if (layersChanged) {
+        m_instanceLayers = visibleLayers;
+    }
+    m_instancesValid = true;
+
+    for (InstanceBuffer& buf : m_instanceBuffers) {
+        uploadInstances(buf);
+    }
+}
+
+void Renderer::uploadVoltages(const ComponentStore& store)
+{
+    const std::vector<int>& ids = store.ids();
+    m_voltageRows.resize(ids.size());
+    for (size_t row = 0; row < ids.size(); ++row) {
+        const auto it = componentVoltages.find(ids[row]);
+        m_voltageRows[row] = it != componentVoltages.end() ? it->second : 0.0f;
+    }
+    if (m_voltageRows.empty()) {
+        return;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, m_voltageBuffer);
+    const int count = static_cast<int>(m_voltageRows.size());
+    if (count > m_voltageCapacity) {
+        m_voltageCapacity = std::max(count, m_voltageCapacity * 2);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(m_voltageCapacity * sizeof(float)),
+                     nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_TEXTURE_BUFFER, 0,
+        static_cast<GLsizeiptr>(m_voltageRows.size() * sizeof(float)), m_voltageRows.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void Renderer::uploadInstances(InstanceBuffer& buf)
+{
+    if (buf.dirty.empty()) {
+        return;
+    }
+    const size_t count = buf.instances.size();
+    if (ensureInstanceCapacity(buf, static_cast<int>(count))) {
+        // A fresh allocation holds nothing, so everything goes up at once.
+        glBufferSubData(GL_ARRAY_BUFFER, 0,
+            static_cast<GLsizeiptr>(count * sizeof(InstanceData)), buf.instances.data());
+        buf.dirty.clear();
+        return;
+    }
+
+    std::sort(buf.dirty.begin(), buf.dirty.end());
+    glBindBuffer(GL_ARRAY_BUFFER, buf.vbo);
+    size_t i = 0;
+    while (i < buf.dirty.size() && buf.dirty[i] < count) {
+        const uint32_t first = buf.dirty[i];
+        uint32_t last = first;
+        // Indices past the end belong to instances removed since they were
+        // marked; the sort puts them last, where the loop stops.
+        while (i < buf.dirty.size() && buf.dirty[i] < count && buf.dirty[i] <= last + INSTANCE_UPLOAD_MERGE_GAP) {
+            last = std::max(last, buf.dirty[i]);
+            ++i;
+        }
+        glBufferSubData(GL_ARRAY_BUFFER,
+            static_cast<GLintptr>(first * sizeof(InstanceData)),
+            static_cast<GLsizeiptr>((last - first + 1) * sizeof(InstanceData)),
+            &buf.instances[first]);
+    }
+    buf.dirty.clear();
 }
 
 /// Draw one board-sized rectangle for every visible layer that has at least
@@ -412,8 +691,8 @@ void Renderer::drawPcbSubstrates(const CircuitGraph& graph,
     glBindVertexArray(0);
 }
 
-void Renderer::draw(const CircuitGraph& graph, const Camera& camera,
-                    float aspectRatio, float elapsedTime)
+void Renderer::draw(const CircuitGraph& graph, const CircuitAnalysis& analysis,
+                    const Camera& camera, float aspectRatio, float elapsedTime)
 {
     // Frame-time diagnostic: useful for comparing instanced vs
     // non-instanced performance on large circuits. Reports at most once
@@ -443,9 +722,10 @@ void Renderer::draw(const CircuitGraph& graph, const Camera& camera,
 
     const float maxVoltage = 5.0f;
     const int gridSize = 10;
-    const auto disconnectedNow = FindDisconnectedComponents(graph.components, graph.connections);
-    const bool hasCycle = IsCircuitLooped(graph.components, graph.connections);
-    const auto loopedSet = FindLoopedComponents(graph.components, graph.connections);
+    // Graph facts come from the caller's per-topology snapshot; nothing here
+    // walks the connection graph.
+    const auto& disconnectedNow = analysis.disconnected;
+    const bool hasCycle = analysis.hasCycle;
     const glm::mat4 view = camera.getView();
     const glm::mat4 projection = camera.getProjection(aspectRatio);
     const glm::vec3 cameraPosition = glm::vec3(glm::inverse(view)[3]);
@@ -472,42 +752,23 @@ void Renderer::draw(const CircuitGraph& graph, const Camera& camera,
     }
 
     if (USE_GPU_INSTANCING && USE_COMPONENT_MESHES) {
-        // Group every visible component's per-instance data by mesh-registry
-        // key, using the exact same model/color logic as the non-instanced
-        // loop below (voltage-to-color mix, hover highlight).
-        std::map<std::string, std::vector<InstanceData>> grouped;
-        for (const auto& c : graph.components) {
-            if (visibleLayers.count(c.layer) == 0) continue;
-            glm::vec3 pos(c.x, c.y + c.layer * 1.0f, c.z);
-
-            float voltage = componentVoltages.count(c.id) ? componentVoltages[c.id] : 0.0f;
-            float normV = glm::clamp(voltage / maxVoltage, 0.0f, 1.0f);
-            glm::vec3 color = glm::mix(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), normV);
-            if (c.id == hoverComponentId) {
-                color = glm::vec3(1.0f, 1.0f, 0.0f);
-            }
-
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
-
-            const std::string key = (m_meshRegistry.count(c.type) > 0) ? c.type : std::string("Cube");
-            InstanceData inst;
-            inst.modelMatrix = model;
-            inst.color = color;
-            inst.pad = 0.0f;
-            grouped[key].push_back(inst);
-        }
-
-        for (auto& [key, instances] : grouped) {
-            if (instances.empty()) continue;
-            InstanceBuffer& buf = m_instanceBuffers[key];
-            ensureInstanceCapacity(buf, static_cast<int>(instances.size()));
-            glBindBuffer(GL_ARRAY_BUFFER, buf.vbo);
-            glBufferSubData(GL_ARRAY_BUFFER, 0,
-                static_cast<GLsizeiptr>(instances.size() * sizeof(InstanceData)), instances.data());
-            const Mesh& mesh = m_meshRegistry.at(key);
+        // Instances persist across frames; syncInstances() rewrites only
+        // the ones whose position, type or layer visibility changed, so an
+        // idle frame is just the draw calls. Color comes from the voltage
+        // texture, the scale and the hover row from uniforms.
+        syncInstances(graph);
+        const ComponentStore& store = graph.componentStore();
+        glUniform1f(m_litMaxVoltageLoc, maxVoltage);
+        glUniform1i(m_litHoverIndexLoc, store.indexOf(hoverComponentId));
+        glActiveTexture(GL_TEXTURE0 + COMPONENT_VOLTAGE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, m_voltageTexture);
+        for (size_t slot = 0; slot < m_instanceBuffers.size(); ++slot) {
+            const InstanceBuffer& buf = m_instanceBuffers[slot];
+            if (buf.instances.empty()) continue;
+            const Mesh& mesh = m_meshRegistry[slot];
             glBindVertexArray(mesh.vao);
             glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, nullptr,
-                static_cast<GLsizei>(instances.size()));
+                static_cast<GLsizei>(buf.instances.size()));
         }
         glBindVertexArray(0);
     } else {
@@ -533,19 +794,13 @@ void Renderer::draw(const CircuitGraph& graph, const Camera& camera,
 
             glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
             if (USE_COMPONENT_MESHES) {
-                const std::string& key = c.type;
-                const Mesh& mesh = (m_meshRegistry.count(key) > 0)
-                    ? m_meshRegistry.at(key)
-                    : m_meshRegistry.at("Cube");
+                const Mesh& mesh = m_meshRegistry[MeshSlotFor(c.type)];
                 glBindVertexArray(mesh.vao);
                 glUniformMatrix4fv(USE_BLINN_PHONG ? m_litModelLoc : modelLoc, 1, GL_FALSE, glm::value_ptr(model));
                 glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
             } else {
-                glm::vec3 scale(1.0f);
-                if (c.type == "Resistor")    scale = glm::vec3(1.0f, 0.5f, 0.5f);
-                else if (c.type == "Capacitor") scale = glm::vec3(0.7f, 1.0f, 0.7f);
-                else if (c.type == "Inductor")  scale = glm::vec3(1.2f, 1.2f, 1.2f);
-                else if (c.type == "Diode")     scale = glm::vec3(0.5f, 0.5f, 1.5f);
+                const float* boxScale = ComponentTypeInfoOf(c.type).boxScale;
+                glm::vec3 scale(boxScale[0], boxScale[1], boxScale[2]);
 
                 model = glm::scale(model, scale);
                 glUniformMatrix4fv(USE_BLINN_PHONG ? m_litModelLoc : modelLoc, 1, GL_FALSE, glm::value_ptr(model));
@@ -588,21 +843,17 @@ void Renderer::draw(const CircuitGraph& graph, const Camera& camera,
 
     if (USE_BEZIER_WIRES) {
         m_wireRenderer.draw(
-            graph.connections, graph.components,
+            graph,
             elapsedTime, view, projection,
             cameraPosition);
     } else {
-        glBindVertexArray(0);
-        glBindVertexArray(lineVAO);
+        const auto& loopedSet = graph.cycleAnalysis().loopedComponents;
+        m_lineVertices.clear();
+        m_pulseInstances.clear();
 
         for (const auto& conn : graph.connections) {
-        const Component* from = nullptr;
-        const Component* to = nullptr;
-
-        for (const auto& c : graph.components) {
-            if (c.id == conn.from_id) from = &c;
-            if (c.id == conn.to_id) to = &c;
-        }
+        const Component* from = graph.findComponent(conn.from_id);
+        const Component* to = graph.findComponent(conn.to_id);
 
         if (!from || !to) continue;
 
@@ -612,83 +863,305 @@ void Renderer::draw(const CircuitGraph& graph, const Camera& camera,
         bool fromVisible = visibleLayers.count(from->layer);
         bool toVisible = visibleLayers.count(to->layer);
 
-        if (!fromVisible || !toVisible) {
-            int connKey = from->id * 1000 + to->id;
-            pulseTrails[connKey].clear();
-            continue;
-        }
+        if (!fromVisible || !toVisible) continue;
 
         glm::vec3 fromPos(from->x, from->y + from->layer * 1.0f, from->z);
         glm::vec3 toPos(to->x, to->y + to->layer * 1.0f, to->z);
+        m_lineVertices.push_back(fromPos);
+        m_lineVertices.push_back(toPos);
 
-        float lineVertices[] = {
-            fromPos.x, fromPos.y, fromPos.z,
-            toPos.x,   toPos.y,   toPos.z
-        };
+        const ConnectionKey connKey = MakeConnectionKey(from->id, to->id);
+        if (!signalEnabled[connKey]) continue;
 
-        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(lineVertices), lineVertices);
+        if (disconnectedNow.empty() && hasCycle) {
+            m_pulseInstances.push_back({fromPos, toPos});
+        }
+        }
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+        // Every line in one call, then every pulse head and trail point in
+        // one more, each from this frame's region of the stream.
+        m_lineStream.beginFrame();
+        const GLintptr lineOffset = m_lineStream.write(
+            m_lineVertices.data(), m_lineVertices.size() * sizeof(glm::vec3), sizeof(float));
+        if (!m_lineVertices.empty() && lineOffset >= 0) {
+            glBindVertexArray(lineVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, m_lineStream.buffer());
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+                reinterpret_cast<void*>(lineOffset));
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glm::mat4 model = glm::mat4(1.0f);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glm::mat4 model = glm::mat4(1.0f);
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glUniform3fv(colorLoc, 1, glm::value_ptr(glm::vec3(0.8f)));
+            glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_lineVertices.size()));
+            glBindVertexArray(0);
+        }
 
-        glUniform3fv(colorLoc, 1, glm::value_ptr(glm::vec3(0.8f)));
-        glDrawArrays(GL_LINES, 0, 2);
-        glBindVertexArray(0);
+        const GLintptr pulseOffset = m_lineStream.write(
+            m_pulseInstances.data(), m_pulseInstances.size() * sizeof(PulseInstance), sizeof(float));
+        if (!m_pulseInstances.empty() && pulseOffset >= 0) {
+            glBindVertexArray(pulseVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, m_lineStream.buffer());
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PulseInstance),
+                reinterpret_cast<void*>(pulseOffset + static_cast<GLintptr>(offsetof(PulseInstance, from))));
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(PulseInstance),
+                reinterpret_cast<void*>(pulseOffset + static_cast<GLintptr>(offsetof(PulseInstance, to))));
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        int connKey = from->id * 1000 + to->id;
-        if (!signalEnabled[connKey]) continue;
+            glUseProgram(m_shaderPulse);
+            glUniformMatrix4fv(m_pulseViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(m_pulseProjLoc, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniform3fv(m_pulseColorLoc, 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 0.0f)));
+            glUniform1f(m_pulseTimeLoc, static_cast<float>(glfwGetTime()));
+            glUniform1f(m_pulsePeriodLoc, PULSE_PERIOD_SECONDS);
+            glUniform1f(m_pulseTrailStepLoc, PULSE_TRAIL_STEP_SECONDS);
+            glUniform1f(m_pulseTrailFadeLoc, PULSE_TRAIL_FADE);
+            glPointSize(PULSE_POINT_SIZE);
+            glDisable(GL_DEPTH_TEST);
+            glDrawArraysInstanced(GL_POINTS, 0, PULSE_TRAIL_POINTS,
+                                  static_cast<GLsizei>(m_pulseInstances.size()));
+            glBindVertexArray(0);
+            glEnable(GL_DEPTH_TEST);
+        }
+        m_lineStream.endFrame();
+    }
 
-        std::vector<glm::vec3> pulsePoints;
-        std::vector<float> pulseBrightness;
+    if (!m_pickRequests.empty()) {
+        drawPickIds(graph, view, projection);
+    }
 
-        if (disconnectedNow.empty() && hasCycle) {
-            auto& trail = pulseTrails[connKey];
-            float period = 2.0f;
-            float t = static_cast<float>(fmod(glfwGetTime(), period)) / period;
-            glm::vec3 pulsePos = (1.0f - t) * fromPos + t * toPos;
+    renderTimeAccumulatorMs += (glfwGetTime() - renderStart) * 1000.0;
+}
 
-            trail.push_back({ pulsePos, 0.0f });
+void Renderer::requestHoverPick(int x, int y)
+{
+    const PickRequest request{x - PICK_HOVER_RADIUS, y - PICK_HOVER_RADIUS,
+                              2 * PICK_HOVER_RADIUS + 1, 2 * PICK_HOVER_RADIUS + 1, PickKind::Hover};
+    for (PickRequest& pending : m_pickRequests) {
+        if (pending.kind == PickKind::Hover) {
+            pending = request;
+            return;
+        }
+    }
+    m_pickRequests.push_back(request);
+}
 
-            for (auto& pt : trail)
-                pt.age += 0.02f;
+void Renderer::requestClickPick(int x, int y)
+{
+    m_pickRequests.push_back({x - PICK_HOVER_RADIUS, y - PICK_HOVER_RADIUS,
+                              2 * PICK_HOVER_RADIUS + 1, 2 * PICK_HOVER_RADIUS + 1, PickKind::Click});
+}
 
-            trail.erase(std::remove_if(trail.begin(), trail.end(),
-                [](const PulseTrail& p) { return p.age > 1.0f; }), trail.end());
+void Renderer::requestBoxPick(int x0, int y0, int x1, int y1)
+{
+    const int left = std::min(x0, x1);
+    const int top = std::min(y0, y1);
+    m_pickRequests.push_back({left, top, std::max(x0, x1) - left + 1, std::max(y0, y1) - top + 1, PickKind::Box});
+}
 
-            glBindVertexArray(pulseVAO);
-            glDisable(GL_DEPTH_TEST);
+void Renderer::drawPickIds(const CircuitGraph& graph, const glm::mat4& view, const glm::mat4& projection)
+{
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (m_pickBuffer.resize(viewport[2], viewport[3])) {
+        m_pickImageValid = false;
+    }
+    const int width = m_pickBuffer.width();
+    const int height = m_pickBuffer.height();
+    if (width <= 0 || height <= 0) {
+        return;   // minimized; the requests wait for a visible frame
+    }
+
+    // Requests are clamped to the target and flipped to GL's bottom-up rows.
+    const auto toRegion = [width, height](const PickRequest& request) {
+        const int x0 = std::clamp(request.x, 0, width - 1);
+        const int y0 = std::clamp(request.y, 0, height - 1);
+        const int x1 = std::clamp(request.x + request.width, x0 + 1, width);
+        const int y1 = std::clamp(request.y + request.height, y0 + 1, height);
+        return PickRegion{x0, height - y1, x1 - x0, y1 - y0};
+    };
+
+    const ComponentStore& store = graph.componentStore();
+    const bool sceneChanged = !m_pickImageValid || view != m_pickView || projection != m_pickProjection ||
+        store.revision != m_pickStoreRevision || graph.topologyVersion() != m_pickTopologyVersion ||
+        visibleLayers != m_pickLayers;
+    PickRegion needed;
+    for (const PickRequest& request : m_pickRequests) {
+        const PickRegion region = toRegion(request);
+        if (sceneChanged || !regionContains(m_pickDrawnRegion, region)) {
+            needed = regionUnion(needed, region);
+        }
+    }
+
+    if (needed.width > 0) {
+        // Only the pixels some request reads are drawn; the scissor keeps
+        // the rest of the image, still valid when the scene is unchanged.
+        const PickRegion drawn = sceneChanged ? needed : regionUnion(m_pickDrawnRegion, needed);
+        m_pickBuffer.bind();
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(drawn.x, drawn.y, drawn.width, drawn.height);
+        const GLuint clearId[4] = {PICK_ID_NONE, 0u, 0u, 0u};
+        glClearBufferuiv(GL_COLOR, 0, clearId);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_DEPTH_TEST);
 
-            for (const auto& pt : trail) {
-                pulsePoints.push_back(pt.pos);
-                pulseBrightness.push_back(1.0f - pt.age);
+        // Boards hide what is behind them on screen, so they go into the
+        // depth buffer without writing an ID.
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        drawPcbSubstrates(graph, view, projection);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        glUseProgram(m_shaderPick);
+        glUniformMatrix4fv(m_pickViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(m_pickProjLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        if (USE_GPU_INSTANCING && USE_COMPONENT_MESHES) {
+            // draw() synced the instances to graph earlier this frame; each
+            // one writes its store row from the instance data.
+            glUniform1i(m_pickUseInstancingLoc, 1);
+            for (size_t slot = 0; slot < m_instanceBuffers.size(); ++slot) {
+                const InstanceBuffer& buf = m_instanceBuffers[slot];
+                if (buf.instances.empty()) continue;
+                const Mesh& mesh = m_meshRegistry[slot];
+                glBindVertexArray(mesh.vao);
+                glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, nullptr,
+                    static_cast<GLsizei>(buf.instances.size()));
+            }
+        } else {
+            glUniform1i(m_pickUseInstancingLoc, 0);
+            if (!USE_COMPONENT_MESHES) {
+                glBindVertexArray(cubeVAO);
+            }
+            // graph.components[row] is component store row `row`.
+            for (size_t row = 0; row < graph.components.size(); ++row) {
+                const Component& c = graph.components[row];
+                if (visibleLayers.count(c.layer) == 0) continue;
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(c.x, c.y + c.layer * 1.0f, c.z));
+                glUniform1ui(m_pickIdLoc, static_cast<GLuint>(row + 1));
+                if (USE_COMPONENT_MESHES) {
+                    const Mesh& mesh = m_meshRegistry[MeshSlotFor(c.type)];
+                    glBindVertexArray(mesh.vao);
+                    glUniformMatrix4fv(m_pickModelLoc, 1, GL_FALSE, glm::value_ptr(model));
+                    glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+                } else {
+                    const float* boxScale = ComponentTypeInfoOf(c.type).boxScale;
+                    model = glm::scale(model, glm::vec3(boxScale[0], boxScale[1], boxScale[2]));
+                    glUniformMatrix4fv(m_pickModelLoc, 1, GL_FALSE, glm::value_ptr(model));
+                    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+                }
             }
         }
+        glBindVertexArray(0);
+        if (USE_BEZIER_WIRES) {
+            m_wireRenderer.drawPickIds(view, projection);
+        }
+        glDisable(GL_SCISSOR_TEST);
+
+        m_pickDrawnRegion = drawn;
+        m_pickView = view;
+        m_pickProjection = projection;
+        m_pickStoreRevision = store.revision;
+        m_pickTopologyVersion = graph.topologyVersion();
+        m_pickLayers = visibleLayers;
+        // Tubes still streaming in will change the image without the scene
+        // changing, so it is redrawn until they have all landed.
+        m_pickImageValid = !USE_BEZIER_WIRES || m_wireRenderer.wiresCurrent();
+        m_hoverRead = false;
+    }
 
-        glBindVertexArray(pulseVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, pulseVBO);
-        glBufferData(GL_ARRAY_BUFFER, pulsePoints.size() * sizeof(glm::vec3), pulsePoints.data(), GL_DYNAMIC_DRAW);
+    size_t kept = 0;
+    for (const PickRequest& request : m_pickRequests) {
+        const PickRegion region = toRegion(request);
+        if (request.kind == PickKind::Hover && m_hoverRead && sameRegion(region, m_lastHoverRegion)) {
+            continue;   // same pixels of the same image: the answer cannot have changed
+        }
+        if (!m_pickBuffer.read(region, m_nextPickTag)) {
+            m_pickRequests[kept++] = request;   // every slot in flight; try next frame
+            continue;
+        }
+        IssuedPick issued;
+        issued.tag = m_nextPickTag++;
+        issued.request = request;
+        issued.topologyVersion = graph.topologyVersion();
+        issued.centerX = request.x + request.width / 2;
+        issued.centerY = height - 1 - (request.y + request.height / 2);
+        m_issuedPicks.push_back(issued);
+        if (request.kind == PickKind::Hover) {
+            m_lastHoverRegion = region;
+            m_hoverRead = true;
+        }
+    }
+    m_pickRequests.resize(kept);
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
 
-        if (disconnectedNow.empty() && hasCycle) {
-            for (size_t i = 0; i < pulsePoints.size(); ++i) {
-                glm::mat4 model = glm::mat4(1.0f);
-                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-                glUniform1f(brightnessLoc, pulseBrightness[i]);
-                glUniform3fv(colorLoc, 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 0.0f)));
-                glPointSize(10.0f);
-                glDrawArrays(GL_POINTS, static_cast<GLint>(i), 1);
+bool Renderer::pollPick(const CircuitGraph& graph, GpuPickResult& result)
+{
+    while (m_pickBuffer.poll(m_pickReadback)) {
+        const uint64_t tag = m_pickReadback.tag;
+        const auto found = std::find_if(m_issuedPicks.begin(), m_issuedPicks.end(),
+            [tag](const IssuedPick& pick) { return pick.tag == tag; });
+        if (found == m_issuedPicks.end()) {
+            continue;
+        }
+        const IssuedPick pick = *found;
+        m_issuedPicks.erase(found);
+        if (pick.topologyVersion != graph.topologyVersion()) {
+            // Rows and connection indices may have moved since it was drawn.
+            if (pick.request.kind != PickKind::Hover) {
+                m_pickRequests.push_back(pick.request);
             }
+            continue;
         }
 
-        glEnable(GL_DEPTH_TEST);
+        const std::vector<int>& ids = graph.componentStore().ids();
+        const std::vector<uint32_t>& pixels = m_pickReadback.ids;
+        const PickRegion& region = m_pickReadback.region;
+        result.kind = pick.request.kind;
+        result.componentId = -1;
+        result.connectionIndex = -1;
+        result.connectionKey = 0;
+        result.componentIds.clear();
+
+        if (pick.request.kind == PickKind::Box) {
+            m_pickSeenRows.assign(ids.size(), 0);
+            for (const uint32_t id : pixels) {
+                if (id == PICK_ID_NONE || (id & PICK_ID_WIRE_BIT) != 0) {
+                    continue;
+                }
+                const size_t row = id - 1u;
+                if (row < ids.size() && m_pickSeenRows[row] == 0) {
+                    m_pickSeenRows[row] = 1;
+                    result.componentIds.push_back(ids[row]);
+                }
+            }
+            return true;
         }
-    }
 
-    renderTimeAccumulatorMs += (glfwGetTime() - renderStart) * 1000.0;
+        uint32_t nearest = PICK_ID_NONE;
+        int nearestDistance = std::numeric_limits<int>::max();
+        for (int j = 0; j < region.height; ++j) {
+            for (int i = 0; i < region.width; ++i) {
+                const uint32_t id = pixels[static_cast<size_t>(j) * static_cast<size_t>(region.width) + static_cast<size_t>(i)];
+                const int dx = region.x + i - pick.centerX;
+                const int dy = region.y + j - pick.centerY;
+                if (id != PICK_ID_NONE && dx * dx + dy * dy < nearestDistance) {
+                    nearestDistance = dx * dx + dy * dy;
+                    nearest = id;
+                }
+            }
+        }
+        if ((nearest & PICK_ID_WIRE_BIT) != 0) {
+            const size_t connection = (nearest & ~PICK_ID_WIRE_BIT) - 1u;
+            if (connection < graph.connections.size()) {
+                result.connectionIndex = static_cast<int>(connection);
+                result.connectionKey = MakeConnectionKey(graph.connections[connection]);
+            }
+        } else if (nearest != PICK_ID_NONE && nearest - 1u < ids.size()) {
+            result.componentId = ids[nearest - 1u];
+        }
+        return true;
+    }
+    return false;
 }
@@ -2,41 +2,77 @@
 
 #include <glm/glm.hpp>
 
-#include <map>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "../circuit/Circuit.h"
 #include "Camera.h"
 #include "MeshBuilder.h"
+#include "PickBuffer.h"
+#include "StreamBuffer.h"
 #include "WireRenderer.h"
 
-/// Stores one animated signal trail point for connection rendering.
-struct PulseTrail {
-    glm::vec3 pos;
-    float age;
+/// One connection carrying a pulse on the straight-line wire path. The
+/// pulse shader derives the head and every trail point from the time.
+struct PulseInstance {
+    glm::vec3 from;
+    glm::vec3 to;
 };
 
 constexpr int INSTANCE_ATTRIB_LOCATION_BASE = 2;   // mat4 -> locations 2,3,4,5
-constexpr int INSTANCE_COLOR_ATTRIB_LOCATION = 6;
+constexpr int INSTANCE_INDEX_ATTRIB_LOCATION = 6;
 constexpr int INITIAL_INSTANCE_CAPACITY = 64;      // starting reserve per mesh type, doubled on growth
+constexpr int COMPONENT_VOLTAGE_TEXTURE_UNIT = 0;
 
 /// Per-instance data uploaded to the GPU for batched component rendering.
-/// One entry per component sharing a given mesh type.
+/// One entry per component sharing a given mesh type. Color is not stored
+/// here: the shader looks the voltage up by componentIndex.
 struct InstanceData {
     glm::mat4 modelMatrix;
-    glm::vec3 color;
-    float pad;   // rounds struct to 80 bytes (16-byte aligned)
+    int32_t componentIndex;   // component store row, indexes the voltage texture
+    float pad[3];             // rounds struct to 80 bytes (16-byte aligned)
 };
 // A silent layout mismatch here corrupts every instanced draw without any
 // compiler error, so the byte size is checked explicitly.
 static_assert(sizeof(InstanceData) == 80,
     "InstanceData layout changed - update glVertexAttribPointer offsets");
 
-/// GPU-side state for one mesh type's instance buffer.
+/// GPU-side state for one mesh type's instance buffer, plus the CPU copy
+/// it was uploaded from. An instance keeps its index until its component is
+/// removed, retyped or hidden; the last instance then moves into the hole.
 struct InstanceBuffer {
     GLuint vbo = 0;
     int capacity = 0;   // current allocated slot count
+    std::vector<InstanceData> instances;
+    std::vector<int> rows;          // component store row drawn by each instance
+    std::vector<uint32_t> dirty;    // instances changed since the last upload
+};
+
+/// Where one component store row is drawn: a mesh slot and an index into
+/// that slot's instances, or -1 while the row is on a hidden layer.
+struct InstancePlacement {
+    uint16_t meshSlot = 0;
+    int index = -1;
+};
+
+/// What an ID buffer pick was asked for.
+enum class PickKind {
+    Hover,   // the cursor, asked for every frame
+    Click,   // a click, read at the pixels where the button was released
+    Box      // a box selection
+};
+
+/// A pick read back from the ID buffer, resolved against the graph.
+struct GpuPickResult {
+    PickKind kind = PickKind::Hover;
+    int componentId = -1;             // hover, click: component nearest the point, or -1
+    int connectionIndex = -1;         // hover, click: wire nearest the point, or -1
+    ConnectionKey connectionKey = 0;
+    std::vector<int> componentIds;    // box: every component visible inside the box
 };
 
 /// Draws the existing cube, axis, grid, connection, and pulse OpenGL scene.
@@ -46,30 +82,95 @@ public:
     bool init();
 
     /// Draws the circuit using the camera view and projection for the current aspect ratio.
-    void draw(const CircuitGraph& graph, const Camera& camera,
-              float aspectRatio, float elapsedTime);
+    /// analysis must describe graph's current topology.
+    void draw(const CircuitGraph& graph, const CircuitAnalysis& analysis,
+              const Camera& camera, float aspectRatio, float elapsedTime);
+
+    /// Asks the next draw() to read back the few ID buffer pixels around
+    /// (x, y), in framebuffer pixels from the top left. Replaces an earlier
+    /// hover request not yet read; one over the same pixels of an unchanged
+    /// scene reads nothing, as its answer would not change.
+    void requestHoverPick(int x, int y);
+
+    /// Asks the next draw() to read back the pixels around a click at
+    /// (x, y). Unlike a hover request it is always read, never replaced.
+    void requestClickPick(int x, int y);
+
+    /// Asks the next draw() to read back every ID buffer pixel in the box
+    /// spanned by two corners, in framebuffer pixels from the top left.
+    void requestBoxPick(int x0, int y0, int x1, int y1);
+
+    /// Takes the oldest finished pick, resolved against graph. Returns false
+    /// while none has finished. A click or box pick drawn before a topology
+    /// change is asked for again; a stale hover pick is dropped.
+    bool pollPick(const CircuitGraph& graph, GpuPickResult& result);
 
 private:
     /// Grow a mesh type's instance buffer if needed. Never shrinks. Never
     /// reallocates when the existing capacity already fits the request.
-    void ensureInstanceCapacity(InstanceBuffer& buf, int neededCount);
+    /// Returns true when it reallocated, which discards the old contents.
+    bool ensureInstanceCapacity(InstanceBuffer& buf, int neededCount);
+
+    /// Brings the persistent instance lists up to date with graph and the
+    /// visible layers, then uploads only the instances that changed, plus
+    /// the voltage texture when the voltages or the rows changed. An
+    /// unchanged frame does no per-component work and no uploads.
+    void syncInstances(const CircuitGraph& graph);
+
+    /// Recomputes one row's instance, moving it between mesh slots or
+    /// dropping it when its type or visibility changed.
+    void refreshInstance(const ComponentStore& store, size_t row);
+
+    /// Rewrites the voltage texture from componentVoltages, one texel per
+    /// store row, in a single upload.
+    void uploadVoltages(const ComponentStore& store);
+
+    /// Detaches a row's instance from its mesh slot.
+    void removeInstance(size_t row);
+
+    /// Uploads the dirty instances of one mesh slot in contiguous runs.
+    void uploadInstances(InstanceBuffer& buf);
 
     /// Draws one FR4-style PCB substrate under each visible circuit layer.
     void drawPcbSubstrates(const CircuitGraph& graph,
                            const glm::mat4& view,
                            const glm::mat4& projection);
 
+    /// A pick waiting for the ID pass, in framebuffer pixels from the top left.
+    struct PickRequest {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        PickKind kind = PickKind::Hover;
+    };
+
+    /// A readback in flight: what it was for and the topology it was drawn at.
+    struct IssuedPick {
+        uint64_t tag = 0;
+        PickRequest request;
+        uint64_t topologyVersion = 0;
+        int centerX = 0;   // request centre in target pixels, bottom-left origin
+        int centerY = 0;
+    };
+
+    /// Redraws the ID buffer where the waiting picks need it, unless it
+    /// still holds this scene there, and queues their readbacks.
+    void drawPickIds(const CircuitGraph& graph, const glm::mat4& view, const glm::mat4& projection);
+
 
     unsigned int shaderProgram = 0;
     unsigned int m_shaderLit = 0;
     unsigned int m_shaderPcb = 0;
+    unsigned int m_shaderPulse = 0;
     unsigned int cubeVAO = 0;
     unsigned int cubeVBO = 0;
     unsigned int cubeEBO = 0;
     unsigned int lineVAO = 0;
-    unsigned int lineVBO = 0;
     unsigned int pulseVAO = 0;
-    unsigned int pulseVBO = 0;
+    StreamBuffer m_lineStream;                    // this frame's lines and pulses, for both VAOs
+    std::vector<glm::vec3> m_lineVertices;        // two per drawn connection
+    std::vector<PulseInstance> m_pulseInstances;  // one per pulsing connection
     unsigned int axisVAO = 0;
     unsigned int axisVBO = 0;
     unsigned int gridVAO = 0;
@@ -79,12 +180,29 @@ private:
     unsigned int pcbEBO = 0;
 
     static constexpr bool USE_COMPONENT_MESHES = true;
-    std::map<std::string, Mesh> m_meshRegistry;
+    MeshRegistry m_meshRegistry;
     static constexpr bool USE_BEZIER_WIRES = true;
     WireRenderer m_wireRenderer;
     static constexpr bool USE_BLINN_PHONG = true;
     static constexpr bool USE_GPU_INSTANCING = true;
-    std::map<std::string, InstanceBuffer> m_instanceBuffers; // keyed same as m_meshRegistry
+    std::array<InstanceBuffer, MESH_SLOT_COUNT> m_instanceBuffers; // indexed same as m_meshRegistry
+
+    // What the instance buffers currently reflect; a mismatch with the
+    // frame's inputs is what triggers per-row work in syncInstances().
+    std::vector<InstancePlacement> m_instancePlacements;   // one per store row
+    std::vector<int> m_instanceIds;                        // store ids() at the last sync
+    uint64_t m_instanceStoreRevision = 0;
+    std::vector<uint32_t> m_editedRows;                    // store rows rewritten since that revision
+    uint64_t m_instanceVoltageRevision = 0;
+    std::set<int> m_instanceLayers;
+    bool m_instancesValid = false;
+
+    // Per-row voltages for the instanced shader, read through a buffer
+    // texture so a new solve never touches instance data.
+    GLuint m_voltageBuffer = 0;
+    GLuint m_voltageTexture = 0;
+    int m_voltageCapacity = 0;
+    std::vector<float> m_voltageRows;
 
     int modelLoc = -1;
     int viewLoc = -1;
@@ -99,10 +217,46 @@ private:
     int m_litLightDirLoc = -1;
     int m_litViewPosLoc = -1;
     int m_litUseInstancingLoc = -1;
+    int m_litVoltagesLoc = -1;
+    int m_litMaxVoltageLoc = -1;
+    int m_litHoverIndexLoc = -1;
 
     int m_pcbModelLoc = -1;
     int m_pcbViewLoc = -1;
     int m_pcbProjLoc = -1;
     int m_pcbBoardColorLoc = -1;
     int m_pcbCopperColorLoc = -1;
+
+    int m_pulseViewLoc = -1;
+    int m_pulseProjLoc = -1;
+    int m_pulseColorLoc = -1;
+    int m_pulseTimeLoc = -1;
+    int m_pulsePeriodLoc = -1;
+    int m_pulseTrailStepLoc = -1;
+    int m_pulseTrailFadeLoc = -1;
+
+    // ID buffer picking. The image is only redrawn when the camera, the
+    // scene or the wanted pixels change.
+    PickBuffer m_pickBuffer;
+    unsigned int m_shaderPick = 0;           // component.vert with pick.frag
+    std::vector<PickRequest> m_pickRequests;
+    std::deque<IssuedPick> m_issuedPicks;
+    uint64_t m_nextPickTag = 1;
+    PickReadback m_pickReadback;
+    std::vector<uint8_t> m_pickSeenRows;     // box resolve scratch, one per store row
+    glm::mat4 m_pickView{1.0f};              // what the ID image was drawn for
+    glm::mat4 m_pickProjection{1.0f};
+    uint64_t m_pickStoreRevision = 0;
+    uint64_t m_pickTopologyVersion = 0;
+    std::set<int> m_pickLayers;
+    PickRegion m_pickDrawnRegion;
+    bool m_pickImageValid = false;
+    PickRegion m_lastHoverRegion;            // last hover readback issued from that image
+    bool m_hoverRead = false;
+
+    int m_pickModelLoc = -1;
+    int m_pickViewLoc = -1;
+    int m_pickProjLoc = -1;
+    int m_pickUseInstancingLoc = -1;
+    int m_pickIdLoc = -1;
 };
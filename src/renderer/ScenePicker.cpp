@@ -0,0 +1,585 @@
+#include "ScenePicker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ELEC3D_PICK_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+constexpr float PICK_MAX_DISTANCE = 1e6f;
+// Wires are picked within a few tube radii of their axis; the tube itself
+// is too thin to hit reliably with a cursor.
+constexpr float WIRE_PICK_RADIUS = 3.0f * TUBE_RADIUS;
+constexpr int WIRE_PICK_SEGMENTS = 16;
+constexpr float PARALLEL_EPSILON = 1e-8f;
+// Past this share of moved primitives a full refit beats walking parents.
+constexpr size_t FULL_REFIT_DIVISOR = 4;
+
+/// Closest approach between the ray origin + s * direction (s >= 0) and the
+/// segment a..b. Returns the ray distance s when they pass within radius,
+/// or a negative value.
+float raySegmentHit(const glm::vec3& origin, const glm::vec3& direction,
+                    const glm::vec3& a, const glm::vec3& b, float radius)
+{
+    const glm::vec3 edge = b - a;
+    const glm::vec3 w0 = origin - a;
+    const float de = glm::dot(direction, edge);
+    const float ee = glm::dot(edge, edge);
+    const float dw = glm::dot(direction, w0);
+    const float ew = glm::dot(edge, w0);
+
+    // direction is unit length, so the closest-line formulas drop d . d.
+    const float denominator = ee - de * de;
+    float u = denominator > PARALLEL_EPSILON ? (ew - de * dw) / denominator : 0.0f;
+    u = std::clamp(u, 0.0f, 1.0f);
+    float s = u * de - dw;
+    if (s < 0.0f) {
+        s = 0.0f;
+        u = ee > PARALLEL_EPSILON ? std::clamp(ew / ee, 0.0f, 1.0f) : 0.0f;
+    }
+
+    const glm::vec3 gap = origin + s * direction - (a + u * edge);
+    return glm::dot(gap, gap) <= radius * radius ? s : -1.0f;
+}
+} // namespace
+
+const PickHit& ScenePicker::pick(const CircuitGraph& graph,
+                                 const std::unordered_set<int>& loopedSet,
+                                 const std::set<int>& visibleLayers,
+                                 const glm::vec3& origin,
+                                 const glm::vec3& direction)
+{
+    const ComponentStore& store = graph.componentStore();
+    if (graph.topologyVersion() != m_topologyVersion || store.size() != m_rowCount) {
+        rebuild(graph);
+    } else if (graph.componentRevision() != m_componentRevision) {
+        refit(graph);
+    }
+
+    if (m_hitValid && origin == m_origin && direction == m_direction && visibleLayers == m_pickedLayers) {
+        return m_hit;
+    }
+    m_origin = origin;
+    m_direction = direction;
+    m_inverseDirection = 1.0f / direction;
+    m_pickedLayers = visibleLayers;
+    m_hit = traverse(loopedSet, visibleLayers);
+    m_hitValid = true;
+    return m_hit;
+}
+
+void ScenePicker::rebuild(const CircuitGraph& graph)
+{
+    const ComponentStore& store = graph.componentStore();
+    const ComponentRenderColumns& columns = store.render();
+    m_rowCount = store.size();
+    m_rowPositions.resize(m_rowCount);
+    m_rowLayers.assign(columns.layer.begin(), columns.layer.end());
+    m_rowTypes.assign(store.types().begin(), store.types().end());
+    m_rowIds.assign(store.ids().begin(), store.ids().end());
+    for (size_t row = 0; row < m_rowCount; ++row) {
+        m_rowPositions[row] = glm::vec3(columns.x[row], columns.y[row] + static_cast<float>(columns.layer[row]),
+                                        columns.z[row]);
+    }
+
+    m_wires.clear();
+    m_rowWires.reset(graph.connections.size());
+    for (size_t i = 0; i < graph.connections.size(); ++i) {
+        const Connection& connection = graph.connections[i];
+        const int fromRow = graph.indexOf(connection.from_id);
+        const int toRow = graph.indexOf(connection.to_id);
+        if (fromRow < 0 || toRow < 0) {
+            continue;
+        }
+        m_rowWires.add(i, static_cast<uint32_t>(m_wires.size()), fromRow, toRow);
+        m_wires.push_back({static_cast<int>(i), MakeConnectionKey(connection), fromRow, toRow});
+    }
+
+    const size_t primitiveCount = m_rowCount + m_wires.size();
+    m_bounds.resize(primitiveCount);
+    m_order.resize(primitiveCount);
+    for (uint32_t p = 0; p < primitiveCount; ++p) {
+        m_bounds[p] = primitiveBounds(p);
+        m_order[p] = p;
+    }
+
+    m_nodes.clear();
+    m_nodeParent.clear();
+    m_nodeParentSlot.clear();
+    m_primitiveNode.assign(primitiveCount, -1);
+    m_primitiveSlot.assign(primitiveCount, 0);
+    if (primitiveCount > 0) {
+        m_nodes.reserve(primitiveCount / (LEAF_SIZE - 1) + 1);
+        buildNode(0, primitiveCount);
+    }
+
+    m_topologyVersion = graph.topologyVersion();
+    m_componentRevision = graph.componentRevision();
+    m_hitValid = false;
+}
+
+void ScenePicker::refit(const CircuitGraph& graph)
+{
+    const ComponentStore& store = graph.componentStore();
+    const ComponentRenderColumns& columns = store.render();
+    const std::vector<ComponentType>& types = store.types();
+    const AdjacencyCSR& adjacency = graph.adjacency();
+
+    // The store's edit log names the rows that can have changed; when it
+    // cannot answer, every row is compared.
+    m_editedRows.clear();
+    const bool logged = store.editedRowsSince(m_componentRevision, m_editedRows);
+    const size_t checkCount = logged ? m_editedRows.size() : m_rowCount;
+    std::vector<uint32_t> moved;
+    for (size_t i = 0; i < checkCount; ++i) {
+        const size_t row = logged ? m_editedRows[i] : i;
+        if (row >= m_rowCount) {
+            continue;
+        }
+        const glm::vec3 position(columns.x[row], columns.y[row] + static_cast<float>(columns.layer[row]),
+                                 columns.z[row]);
+        if (position == m_rowPositions[row] && columns.layer[row] == m_rowLayers[row] &&
+            types[row] == m_rowTypes[row]) {
+            continue;
+        }
+        m_rowPositions[row] = position;
+        m_rowLayers[row] = columns.layer[row];
+        m_rowTypes[row] = types[row];
+        moved.push_back(static_cast<uint32_t>(row));
+        const size_t firstWire = moved.size();
+        m_rowWires.appendWires(adjacency, row, moved);
+        for (size_t entry = firstWire; entry < moved.size(); ++entry) {
+            moved[entry] += static_cast<uint32_t>(m_rowCount);   // wire index to primitive index
+        }
+    }
+    m_componentRevision = graph.componentRevision();
+    if (moved.empty()) {
+        return;   // a value edit: every box, and so the cached hit, still holds
+    }
+    m_hitValid = false;
+
+    std::sort(moved.begin(), moved.end());
+    moved.erase(std::unique(moved.begin(), moved.end()), moved.end());
+    for (uint32_t p : moved) {
+        m_bounds[p] = primitiveBounds(p);
+    }
+
+    // Children always get higher indices than their parent, so walking
+    // nodes from the back refits every child before the node holding it.
+    if (moved.size() > m_bounds.size() / FULL_REFIT_DIVISOR) {
+        for (size_t n = m_nodes.size(); n-- > 0;) {
+            Node& node = m_nodes[n];
+            for (int slot = 0; slot < node.slotCount; ++slot) {
+                updateSlot(node, slot);
+            }
+        }
+        return;
+    }
+
+    std::vector<uint8_t> queued(m_nodes.size(), 0);
+    std::priority_queue<int32_t> pending;
+    for (uint32_t p : moved) {
+        const int32_t n = m_primitiveNode[p];
+        updateSlot(m_nodes[static_cast<size_t>(n)], m_primitiveSlot[p]);
+        if (!queued[static_cast<size_t>(n)]) {
+            queued[static_cast<size_t>(n)] = 1;
+            pending.push(n);
+        }
+    }
+    while (!pending.empty()) {
+        const int32_t n = pending.top();
+        pending.pop();
+        const int32_t parent = m_nodeParent[static_cast<size_t>(n)];
+        if (parent < 0) {
+            continue;
+        }
+        updateSlot(m_nodes[static_cast<size_t>(parent)], m_nodeParentSlot[static_cast<size_t>(n)]);
+        if (!queued[static_cast<size_t>(parent)]) {
+            queued[static_cast<size_t>(parent)] = 1;
+            pending.push(parent);
+        }
+    }
+}
+
+int32_t ScenePicker::buildNode(size_t begin, size_t end)
+{
+    const int32_t index = static_cast<int32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+    m_nodeParent.push_back(-1);
+    m_nodeParentSlot.push_back(0);
+
+    // Split the largest oversized range at its median centroid along its
+    // longest axis until there are four ranges or all of them fit a leaf.
+    std::vector<std::pair<size_t, size_t>> ranges{{begin, end}};
+    while (ranges.size() < static_cast<size_t>(NODE_WIDTH)) {
+        size_t largest = ranges.size();
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            const size_t size = ranges[i].second - ranges[i].first;
+            if (size > static_cast<size_t>(LEAF_SIZE) &&
+                (largest == ranges.size() || size > ranges[largest].second - ranges[largest].first)) {
+                largest = i;
+            }
+        }
+        if (largest == ranges.size()) {
+            break;
+        }
+
+        const auto [first, last] = ranges[largest];
+        glm::vec3 low(std::numeric_limits<float>::max());
+        glm::vec3 high(std::numeric_limits<float>::lowest());
+        for (size_t i = first; i < last; ++i) {
+            const Bounds& bounds = m_bounds[m_order[i]];
+            const glm::vec3 centroid = 0.5f * (bounds.min + bounds.max);
+            low = glm::min(low, centroid);
+            high = glm::max(high, centroid);
+        }
+        const glm::vec3 extent = high - low;
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const size_t middle = first + (last - first) / 2;
+        std::nth_element(m_order.begin() + static_cast<std::ptrdiff_t>(first),
+                         m_order.begin() + static_cast<std::ptrdiff_t>(middle),
+                         m_order.begin() + static_cast<std::ptrdiff_t>(last),
+                         [this, axis](uint32_t a, uint32_t b) {
+                             return m_bounds[a].min[axis] + m_bounds[a].max[axis] <
+                                    m_bounds[b].min[axis] + m_bounds[b].max[axis];
+                         });
+        ranges[largest] = {first, middle};
+        ranges.insert(ranges.begin() + static_cast<std::ptrdiff_t>(largest) + 1, {middle, last});
+    }
+
+    m_nodes[static_cast<size_t>(index)].slotCount = static_cast<uint8_t>(ranges.size());
+    for (size_t slot = 0; slot < ranges.size(); ++slot) {
+        const auto [first, last] = ranges[slot];
+        const size_t size = last - first;
+        int32_t child = static_cast<int32_t>(first);
+        uint8_t count = static_cast<uint8_t>(size);
+        if (size > static_cast<size_t>(LEAF_SIZE)) {
+            child = buildNode(first, last);   // may reallocate m_nodes
+            count = 0;
+            m_nodeParent[static_cast<size_t>(child)] = index;
+            m_nodeParentSlot[static_cast<size_t>(child)] = static_cast<uint8_t>(slot);
+        } else {
+            for (size_t i = first; i < last; ++i) {
+                m_primitiveNode[m_order[i]] = index;
+                m_primitiveSlot[m_order[i]] = static_cast<uint8_t>(slot);
+            }
+        }
+        Node& node = m_nodes[static_cast<size_t>(index)];
+        node.child[slot] = child;
+        node.count[slot] = count;
+        updateSlot(node, static_cast<int>(slot));
+    }
+    return index;
+}
+
+void ScenePicker::updateSlot(Node& node, int slot)
+{
+    glm::vec3 low(std::numeric_limits<float>::max());
+    glm::vec3 high(std::numeric_limits<float>::lowest());
+    if (node.count[slot] > 0) {
+        const size_t first = static_cast<size_t>(node.child[slot]);
+        for (size_t i = first; i < first + node.count[slot]; ++i) {
+            const Bounds& bounds = m_bounds[m_order[i]];
+            low = glm::min(low, bounds.min);
+            high = glm::max(high, bounds.max);
+        }
+    } else {
+        const Node& child = m_nodes[static_cast<size_t>(node.child[slot])];
+        for (int i = 0; i < child.slotCount; ++i) {
+            low = glm::min(low, glm::vec3(child.minX[i], child.minY[i], child.minZ[i]));
+            high = glm::max(high, glm::vec3(child.maxX[i], child.maxY[i], child.maxZ[i]));
+        }
+    }
+    node.minX[slot] = low.x;
+    node.minY[slot] = low.y;
+    node.minZ[slot] = low.z;
+    node.maxX[slot] = high.x;
+    node.maxY[slot] = high.y;
+    node.maxZ[slot] = high.z;
+}
+
+ScenePicker::Bounds ScenePicker::primitiveBounds(uint32_t primitive) const
+{
+    if (primitive < m_rowCount) {
+        return componentBounds(primitive);
+    }
+
+    // A Bezier curve stays inside the box of its control points.
+    glm::vec3 points[4];
+    wireCurve(m_wires[primitive - m_rowCount], points);
+    Bounds bounds{points[0], points[0]};
+    for (const glm::vec3& point : points) {
+        bounds.min = glm::min(bounds.min, point);
+        bounds.max = glm::max(bounds.max, point);
+    }
+    bounds.min -= glm::vec3(WIRE_PICK_RADIUS);
+    bounds.max += glm::vec3(WIRE_PICK_RADIUS);
+    return bounds;
+}
+
+ScenePicker::Bounds ScenePicker::componentBounds(size_t row) const
+{
+    const float* boxScale = ComponentTypeInfoOf(m_rowTypes[row]).boxScale;
+    const glm::vec3 halfExtents = 0.5f * glm::vec3(boxScale[0], boxScale[1], boxScale[2]);
+    return {m_rowPositions[row] - halfExtents, m_rowPositions[row] + halfExtents};
+}
+
+void ScenePicker::wireCurve(const PickWire& wire, glm::vec3 points[4]) const
+{
+    wireControlPoints(m_rowPositions[static_cast<size_t>(wire.fromRow)],
+                      m_rowPositions[static_cast<size_t>(wire.toRow)], points);
+}
+
+int ScenePicker::intersectNode(const Node& node, float tMax, float tNear[NODE_WIDTH]) const
+{
+    const int usedSlots = (1 << node.slotCount) - 1;
+#ifdef ELEC3D_PICK_SSE
+    const __m128 originX = _mm_set1_ps(m_origin.x);
+    const __m128 originY = _mm_set1_ps(m_origin.y);
+    const __m128 originZ = _mm_set1_ps(m_origin.z);
+    const __m128 inverseX = _mm_set1_ps(m_inverseDirection.x);
+    const __m128 inverseY = _mm_set1_ps(m_inverseDirection.y);
+    const __m128 inverseZ = _mm_set1_ps(m_inverseDirection.z);
+
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), originX), inverseX);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), originX), inverseX);
+    __m128 entry = _mm_min_ps(t0, t1);
+    __m128 exit = _mm_max_ps(t0, t1);
+    t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), originY), inverseY);
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), originY), inverseY);
+    entry = _mm_max_ps(entry, _mm_min_ps(t0, t1));
+    exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+    t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), originZ), inverseZ);
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), originZ), inverseZ);
+    entry = _mm_max_ps(_mm_max_ps(entry, _mm_min_ps(t0, t1)), _mm_setzero_ps());
+    exit = _mm_min_ps(_mm_min_ps(exit, _mm_max_ps(t0, t1)), _mm_set1_ps(tMax));
+
+    _mm_storeu_ps(tNear, entry);
+    return _mm_movemask_ps(_mm_cmple_ps(entry, exit)) & usedSlots;
+#else
+    int mask = 0;
+    for (int slot = 0; slot < node.slotCount; ++slot) {
+        const float x0 = (node.minX[slot] - m_origin.x) * m_inverseDirection.x;
+        const float x1 = (node.maxX[slot] - m_origin.x) * m_inverseDirection.x;
+        const float y0 = (node.minY[slot] - m_origin.y) * m_inverseDirection.y;
+        const float y1 = (node.maxY[slot] - m_origin.y) * m_inverseDirection.y;
+        const float z0 = (node.minZ[slot] - m_origin.z) * m_inverseDirection.z;
+        const float z1 = (node.maxZ[slot] - m_origin.z) * m_inverseDirection.z;
+        const float entry = std::max({std::min(x0, x1), std::min(y0, y1), std::min(z0, z1), 0.0f});
+        const float exit = std::min({std::max(x0, x1), std::max(y0, y1), std::max(z0, z1), tMax});
+        tNear[slot] = entry;
+        if (entry <= exit) {
+            mask |= 1 << slot;
+        }
+    }
+    return mask & usedSlots;
+#endif
+}
+
+float ScenePicker::intersectPrimitive(uint32_t primitive,
+                                      const std::unordered_set<int>& loopedSet,
+                                      const std::set<int>& visibleLayers) const
+{
+    if (primitive < m_rowCount) {
+        if (visibleLayers.count(m_rowLayers[primitive]) == 0) {
+            return -1.0f;
+        }
+        // The leaf box is the component box, so its slab test is exact.
+        const Bounds& bounds = m_bounds[primitive];
+        const glm::vec3 t0 = (bounds.min - m_origin) * m_inverseDirection;
+        const glm::vec3 t1 = (bounds.max - m_origin) * m_inverseDirection;
+        const glm::vec3 entry = glm::min(t0, t1);
+        const glm::vec3 exit = glm::max(t0, t1);
+        const float tEntry = std::max({entry.x, entry.y, entry.z, 0.0f});
+        const float tExit = std::min({exit.x, exit.y, exit.z});
+        return tEntry <= tExit ? tEntry : -1.0f;
+    }
+
+    // Only wires the renderer draws can be picked: looped at both ends and
+    // on visible layers.
+    const PickWire& wire = m_wires[primitive - m_rowCount];
+    const size_t fromRow = static_cast<size_t>(wire.fromRow);
+    const size_t toRow = static_cast<size_t>(wire.toRow);
+    if (visibleLayers.count(m_rowLayers[fromRow]) == 0 || visibleLayers.count(m_rowLayers[toRow]) == 0 ||
+        loopedSet.count(m_rowIds[fromRow]) == 0 || loopedSet.count(m_rowIds[toRow]) == 0) {
+        return -1.0f;
+    }
+    glm::vec3 points[4];
+    wireCurve(wire, points);
+    float nearest = -1.0f;
+    glm::vec3 previous = points[0];
+    for (int segment = 1; segment <= WIRE_PICK_SEGMENTS; ++segment) {
+        const float t = static_cast<float>(segment) / static_cast<float>(WIRE_PICK_SEGMENTS);
+        const glm::vec3 next = bezierPoint(points[0], points[1], points[2], points[3], t);
+        const float s = raySegmentHit(m_origin, m_direction, previous, next, WIRE_PICK_RADIUS);
+        if (s >= 0.0f && (nearest < 0.0f || s < nearest)) {
+            nearest = s;
+        }
+        previous = next;
+    }
+    return nearest;
+}
+
+PickHit ScenePicker::traverse(const std::unordered_set<int>& loopedSet, const std::set<int>& visibleLayers) const
+{
+    PickHit hit;
+    if (m_nodes.empty()) {
+        return hit;
+    }
+
+    // Components win ties with wires, and lower rows win ties with higher
+    // ones, so the result does not depend on the tree's layout.
+    float best = PICK_MAX_DISTANCE;
+    uint32_t bestPrimitive = std::numeric_limits<uint32_t>::max();
+    struct Entry {
+        int32_t node;
+        float tNear;
+    };
+    std::vector<Entry> stack;
+    stack.push_back({0, 0.0f});
+    while (!stack.empty()) {
+        const Entry entry = stack.back();
+        stack.pop_back();
+        if (entry.tNear > best) {
+            continue;
+        }
+        const Node& node = m_nodes[static_cast<size_t>(entry.node)];
+        alignas(16) float tNear[NODE_WIDTH];
+        const int mask = intersectNode(node, best, tNear);
+
+        // Leaves are tested nearest first, so a close hit prunes the rest;
+        // inner children go on the stack far to near so the nearest is
+        // visited next.
+        int order[NODE_WIDTH];
+        int hits = 0;
+        for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+            if (mask & (1 << slot)) {
+                order[hits++] = slot;
+            }
+        }
+        std::sort(order, order + hits, [&tNear](int a, int b) { return tNear[a] < tNear[b]; });
+        for (int i = 0; i < hits; ++i) {
+            const int slot = order[i];
+            if (node.count[slot] == 0 || tNear[slot] > best) {
+                continue;
+            }
+            const size_t first = static_cast<size_t>(node.child[slot]);
+            for (size_t k = first; k < first + node.count[slot]; ++k) {
+                const uint32_t primitive = m_order[k];
+                const float t = intersectPrimitive(primitive, loopedSet, visibleLayers);
+                if (t >= 0.0f && (t < best || (t == best && primitive < bestPrimitive))) {
+                    best = t;
+                    bestPrimitive = primitive;
+                }
+            }
+        }
+        for (int i = hits; i-- > 0;) {
+            const int slot = order[i];
+            if (node.count[slot] == 0 && tNear[slot] <= best) {
+                stack.push_back({node.child[slot], tNear[slot]});
+            }
+        }
+    }
+
+    if (bestPrimitive == std::numeric_limits<uint32_t>::max()) {
+        return hit;
+    }
+    hit.distance = best;
+    if (bestPrimitive < m_rowCount) {
+        hit.componentId = m_rowIds[bestPrimitive];
+    } else {
+        const PickWire& wire = m_wires[bestPrimitive - m_rowCount];
+        hit.connectionIndex = wire.connection;
+        hit.connectionKey = wire.key;
+    }
+    return hit;
+}
+
+#ifdef ELEC3D_TEST_PICKING
+
+#include <cassert>
+#include <iostream>
+#include <random>
+
+/// Checks the hierarchy against a brute-force box scan, and a refitted
+/// picker against a freshly built one after random moves.
+void TestScenePicker()
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coordinate(-20.0f, 20.0f);
+    CircuitGraph graph;
+    for (int id = 0; id < 2000; ++id) {
+        Component component{};
+        component.id = id;
+        component.type = static_cast<ComponentType>(id % static_cast<int>(BUILTIN_COMPONENT_TYPE_COUNT));
+        component.x = coordinate(rng);
+        component.y = coordinate(rng);
+        component.z = coordinate(rng);
+        component.layer = 1 + id % 3;
+        graph.components.push_back(component);
+    }
+    graph.markTopologyChanged();
+    const std::set<int> layers = {1, 2};
+    std::unordered_set<int> looped;
+
+    const auto randomRay = [&](glm::vec3& origin, glm::vec3& direction) {
+        origin = glm::vec3(coordinate(rng), coordinate(rng), 40.0f);
+        const Component& target = graph.components[rng() % graph.components.size()];
+        direction = glm::normalize(glm::vec3(target.x, target.y + target.layer, target.z) - origin);
+    };
+
+    ScenePicker picker;
+    for (int i = 0; i < 500; ++i) {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        randomRay(origin, direction);
+        int expected = -1;
+        float closest = PICK_MAX_DISTANCE;
+        for (const Component& c : graph.components) {
+            if (layers.count(c.layer) == 0) {
+                continue;
+            }
+            const float* boxScale = ComponentTypeInfoOf(c.type).boxScale;
+            const glm::vec3 half = 0.5f * glm::vec3(boxScale[0], boxScale[1], boxScale[2]);
+            const glm::vec3 center(c.x, c.y + c.layer, c.z);
+            const glm::vec3 t0 = (center - half - origin) / direction;
+            const glm::vec3 t1 = (center + half - origin) / direction;
+            const float entry = std::max({std::min(t0.x, t1.x), std::min(t0.y, t1.y), std::min(t0.z, t1.z), 0.0f});
+            const float exit = std::min({std::max(t0.x, t1.x), std::max(t0.y, t1.y), std::max(t0.z, t1.z)});
+            if (entry <= exit && entry < closest) {
+                closest = entry;
+                expected = c.id;
+            }
+        }
+        assert(picker.pick(graph, looped, layers, origin, direction).componentId == expected);
+    }
+
+    for (size_t i = 0; i + 1 < graph.components.size(); i += 3) {
+        graph.connections.push_back({graph.components[i].id, graph.components[i + 1].id});
+        looped.insert(graph.components[i].id);
+        looped.insert(graph.components[i + 1].id);
+    }
+    graph.markTopologyChanged();
+    for (int step = 0; step < 200; ++step) {
+        Component& moved = graph.components[rng() % graph.components.size()];
+        moved.x = coordinate(rng);
+        graph.markComponentEdited(moved.id);
+
+        glm::vec3 origin;
+        glm::vec3 direction;
+        randomRay(origin, direction);
+        ScenePicker fresh;
+        const PickHit refitted = picker.pick(graph, looped, layers, origin, direction);
+        const PickHit rebuilt = fresh.pick(graph, looped, layers, origin, direction);
+        assert(refitted.componentId == rebuilt.componentId);
+        assert(refitted.connectionIndex == rebuilt.connectionIndex);
+    }
+    std::cerr << "[Elec3D] ScenePicker: hierarchy matches brute force\n";
+}
+
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../circuit/Circuit.h"
+#include "WireRenderer.h"
+
+/// What a pick ray hit first: a component, a wire, or nothing.
+struct PickHit {
+    int componentId = -1;          // hit component, or -1
+    int connectionIndex = -1;      // hit wire's index into graph.connections, or -1
+    ConnectionKey connectionKey = 0;
+    float distance = 0.0f;         // along the ray from its origin
+};
+
+/// Ray picking for hover and click selection over component boxes and wire
+/// tubes. Primitives live in a 4-wide bounding volume hierarchy whose nodes
+/// store their children's boxes one array per axis, so one node visit tests
+/// all four boxes at once. Topology changes rebuild it; component edits
+/// refit only the boxes above the moved parts. A pick whose ray, scene and
+/// visible layers match the previous one returns the cached hit.
+class ScenePicker {
+public:
+    /// Returns the nearest component or wire the ray hits, among components
+    /// on visible layers and wires drawn between looped components on
+    /// visible layers. direction must be normalized.
+    const PickHit& pick(const CircuitGraph& graph,
+                        const std::unordered_set<int>& loopedSet,
+                        const std::set<int>& visibleLayers,
+                        const glm::vec3& origin,
+                        const glm::vec3& direction);
+
+private:
+    static constexpr int NODE_WIDTH = 4;
+    static constexpr int LEAF_SIZE = 4;
+
+    /// Four child boxes, structure-of-arrays. A slot with count > 0 is a
+    /// leaf holding m_order[child .. child + count); otherwise child is a
+    /// node index. Slots past slotCount are unused.
+    struct alignas(16) Node {
+        float minX[NODE_WIDTH];
+        float minY[NODE_WIDTH];
+        float minZ[NODE_WIDTH];
+        float maxX[NODE_WIDTH];
+        float maxY[NODE_WIDTH];
+        float maxZ[NODE_WIDTH];
+        int32_t child[NODE_WIDTH];
+        uint8_t count[NODE_WIDTH];
+        uint8_t slotCount;
+    };
+
+    struct Bounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    /// One wire primitive: the connection it stands for and its endpoint rows.
+    struct PickWire {
+        int connection = 0;
+        ConnectionKey key = 0;
+        int fromRow = 0;
+        int toRow = 0;
+    };
+
+    /// Re-reads every primitive and builds a new hierarchy.
+    void rebuild(const CircuitGraph& graph);
+
+    /// Updates the boxes of rows whose position, layer or type changed and
+    /// of the wires touching them, then refits their ancestors.
+    void refit(const CircuitGraph& graph);
+
+    /// Builds the node for m_order[begin, end) and returns its index.
+    int32_t buildNode(size_t begin, size_t end);
+
+    /// Recomputes one slot's box from its leaf primitives or child node.
+    void updateSlot(Node& node, int slot);
+
+    Bounds primitiveBounds(uint32_t primitive) const;
+    Bounds componentBounds(size_t row) const;
+    void wireCurve(const PickWire& wire, glm::vec3 points[4]) const;
+
+    /// Slab test of all four child boxes against the ray; returns a bit per
+    /// slot hit within [0, tMax] and writes each slot's entry distance.
+    int intersectNode(const Node& node, float tMax, float tNear[NODE_WIDTH]) const;
+
+    /// Exact test of one primitive; returns its distance or a negative value.
+    float intersectPrimitive(uint32_t primitive,
+                             const std::unordered_set<int>& loopedSet,
+                             const std::set<int>& visibleLayers) const;
+
+    PickHit traverse(const std::unordered_set<int>& loopedSet, const std::set<int>& visibleLayers) const;
+
+    // Primitives: store rows first, then wires.
+    size_t m_rowCount = 0;
+    std::vector<glm::vec3> m_rowPositions;
+    std::vector<int> m_rowLayers;
+    std::vector<ComponentType> m_rowTypes;
+    std::vector<int> m_rowIds;
+    std::vector<PickWire> m_wires;
+    std::vector<Bounds> m_bounds;               // per primitive
+    RowWireLookup m_rowWires;                   // wires on each row, through the graph's adjacency
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_order;              // primitives grouped by leaf
+    std::vector<int32_t> m_primitiveNode;       // leaf node and slot per primitive
+    std::vector<uint8_t> m_primitiveSlot;
+    std::vector<int32_t> m_nodeParent;          // parent node and slot per node, -1 for the root
+    std::vector<uint8_t> m_nodeParentSlot;
+    uint64_t m_topologyVersion = 0;
+    uint64_t m_componentRevision = 0;
+    std::vector<uint32_t> m_editedRows;         // store rows rewritten since m_componentRevision
+
+    // The ray and scene the cached hit was computed for.
+    glm::vec3 m_origin{0.0f};
+    glm::vec3 m_direction{0.0f};
+    glm::vec3 m_inverseDirection{0.0f};
+    std::set<int> m_pickedLayers;
+    bool m_hitValid = false;              // cleared whenever a box changes
+    PickHit m_hit;
+};
@@ -0,0 +1,110 @@
+#include "StreamBuffer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr GLuint64 FENCE_WAIT_NANOSECONDS = 1000000000;   // one second per retry
+}
+
+bool StreamBuffer::init(size_t regionBytes)
+{
+    glGenBuffers(1, &m_buffer);
+    if (m_buffer == 0) {
+        std::cerr << "[Elec3D] StreamBuffer: failed to create buffer\n";
+        return false;
+    }
+    reallocate(regionBytes);
+    return true;
+}
+
+void StreamBuffer::beginFrame()
+{
+    m_region = (m_region + 1) % REGION_COUNT;
+    m_used = 0;
+    GLsync& fence = m_fences[static_cast<size_t>(m_region)];
+    if (fence == nullptr) {
+        return;
+    }
+    // Normally already signaled: the region was last drawn from
+    // REGION_COUNT frames ago.
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_NANOSECONDS);
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fence, 0, FENCE_WAIT_NANOSECONDS);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+GLintptr StreamBuffer::write(const void* data, size_t bytes, size_t alignment)
+{
+    size_t offset = (m_used + alignment - 1) / alignment * alignment;
+    if (offset + bytes > m_regionBytes) {
+        reallocate(std::max(m_regionBytes * 2, bytes + alignment));
+        offset = 0;
+    }
+    const GLintptr start = static_cast<GLintptr>(static_cast<size_t>(m_region) * m_regionBytes + offset);
+    m_used = offset + bytes;
+    if (bytes == 0) {
+        return start;
+    }
+
+    // The fence in beginFrame() already guarantees the GPU is done with
+    // this range, so the driver need not synchronize again.
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, start, static_cast<GLsizeiptr>(bytes),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped == nullptr) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        std::cerr << "[Elec3D] StreamBuffer: failed to map " << bytes << " bytes\n";
+        return -1;
+    }
+    std::memcpy(mapped, data, bytes);
+    const bool intact = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return intact ? start : -1;
+}
+
+void StreamBuffer::endFrame()
+{
+    GLsync& fence = m_fences[static_cast<size_t>(m_region)];
+    if (fence != nullptr) {
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::shutdown()
+{
+    for (GLsync& fence : m_fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (m_buffer != 0) {
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+    m_regionBytes = 0;
+    m_used = 0;
+}
+
+void StreamBuffer::reallocate(size_t regionBytes)
+{
+    // Orphaning hands the old storage to whatever draws still read it, so
+    // the old fences no longer guard anything in the new storage.
+    for (GLsync& fence : m_fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    m_regionBytes = regionBytes;
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_regionBytes * REGION_COUNT),
+                 nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
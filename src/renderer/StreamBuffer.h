@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+/// Vertex buffer for data rewritten every frame, split into a ring of
+/// per-frame regions. A frame writes only its own region, and a region is
+/// reused only after the GPU has passed the fence placed when it was last
+/// drawn from, so writes never stall on or overwrite data still in flight.
+class StreamBuffer {
+public:
+    /// Creates the buffer with regionBytes per frame. Returns false when the
+    /// buffer could not be created.
+    bool init(size_t regionBytes);
+
+    /// Starts a new frame: moves to the next region and waits until the
+    /// GPU has finished reading it.
+    void beginFrame();
+
+    /// Copies bytes into the current region and returns its offset in the
+    /// buffer, aligned to alignment. Grows every region when the frame no
+    /// longer fits; that orphans the buffer, so issue the draws for one
+    /// write before making the next. Returns -1 when mapping fails.
+    GLintptr write(const void* data, size_t bytes, size_t alignment);
+
+    /// Fences the current region once this frame's draws from it are issued.
+    void endFrame();
+
+    GLuint buffer() const
+    {
+        return m_buffer;
+    }
+
+    /// Frees the buffer and any pending fences.
+    void shutdown();
+
+private:
+    static constexpr int REGION_COUNT = 3;   // frames the GPU may lag behind by
+
+    void reallocate(size_t regionBytes);
+
+    GLuint m_buffer = 0;
+    size_t m_regionBytes = 0;
+    size_t m_used = 0;                       // bytes written this frame
+    int m_region = 0;
+    std::array<GLsync, REGION_COUNT> m_fences{};
+};
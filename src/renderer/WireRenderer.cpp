@@ -1,8 +1,13 @@
 #include "WireRenderer.h"
 
+#include <algorithm>
 #include <cmath>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <unordered_map>
@@ -12,16 +17,27 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-extern std::unordered_map<int, bool> signalEnabled;
+#include "../util/ParallelFor.h"
+#include "PickBuffer.h"
+
+extern std::unordered_map<ConnectionKey, bool> signalEnabled;
+extern uint64_t signalEnabledRevision;
 extern std::set<int> visibleLayers;
+extern bool gpuWireTessellation;
 
 namespace {
 
 constexpr int RING_VERTEX_COUNT = TUBE_SIDES + 1;
 constexpr int STRIP_VERTEX_COUNT = RING_VERTEX_COUNT * 2;
-constexpr int CONNECTION_KEY_SCALE = 1000;
+constexpr int WIRE_VERTEX_COUNT = (WIRE_SEGMENTS + 1) * RING_VERTEX_COUNT;
+constexpr int WIRE_INDEX_COUNT = WIRE_SEGMENTS * (STRIP_VERTEX_COUNT + 1);   // +1 restart per strip
 constexpr int SHADER_LOG_SIZE = 512;
-constexpr unsigned int POSITION_FLOAT_COUNT = 3u;
+// A full rebuild reaches the GPU over several frames in slices this size
+// (about 6 MB), so a large layout never stalls one frame on its upload.
+constexpr size_t WIRE_UPLOAD_VERTICES_PER_FRAME = 262144;
+// Fewer wires than this per worker cost more in waking the pool and
+// handing out chunks than they save.
+constexpr size_t MIN_WIRES_PER_CHUNK = 64;
 const glm::vec3 WORLD_UP(WIRE_ZERO, WIRE_ONE, WIRE_ZERO);
 const glm::vec3 WORLD_RIGHT(WIRE_ONE, WIRE_ZERO, WIRE_ZERO);
 const glm::vec3 INACTIVE_WIRE_COLOR(0.55f, 0.55f, 0.60f);
@@ -63,22 +79,22 @@ GLuint compileShader(GLenum type, const char* path, const char* source)
     return shader;
 }
 
-/// Link the wire shader program and log stderr details on failure.
-GLuint loadWireShader()
+/// Link a wire shader program and log stderr details on failure.
+GLuint loadWireShader(const char* vertexPath, const char* fragmentPath)
 {
     std::string vertexSource;
     std::string fragmentSource;
-    if (!loadShaderSource("../shaders/wire.vert", vertexSource) ||
-        !loadShaderSource("../shaders/wire.frag", fragmentSource)) {
+    if (!loadShaderSource(vertexPath, vertexSource) ||
+        !loadShaderSource(fragmentPath, fragmentSource)) {
         return 0;
     }
 
-    GLuint vertex = compileShader(GL_VERTEX_SHADER, "../shaders/wire.vert", vertexSource.c_str());
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, vertexPath, vertexSource.c_str());
     if (vertex == 0) {
         return 0;
     }
 
-    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, "../shaders/wire.frag", fragmentSource.c_str());
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, fragmentPath, fragmentSource.c_str());
     if (fragment == 0) {
         glDeleteShader(vertex);
         return 0;
@@ -105,62 +121,54 @@ GLuint loadWireShader()
     return program;
 }
 
-/// Return a component pointer by ID without changing circuit storage.
-const Component* findComponent(const std::vector<Component>& components, int id)
+/// World-space position of one component store row, in the same
+/// convention as Renderer.
+glm::vec3 rowPosition(const ComponentRenderColumns& columns, size_t row)
 {
-    for (const auto& component : components) {
-        if (component.id == id) {
-            return &component;
-        }
-    }
-    return nullptr;
+    return glm::vec3(columns.x[row], columns.y[row] + static_cast<float>(columns.layer[row]), columns.z[row]);
 }
 
-/// Convert component data into the same world-space convention as Renderer.
-glm::vec3 componentPosition(const Component& component)
+/// Upload elements [first, first + count) of data into buffer, growing the
+/// buffer first when data no longer fits; a regrown buffer gets everything.
+template <typename T>
+void uploadRange(GLenum target, GLuint buffer, int& capacity, const std::vector<T>& data,
+                 size_t first, size_t count)
 {
-    return glm::vec3(component.x, component.y + static_cast<float>(component.layer), component.z);
-}
-
-/// Return true if connection endpoints changed since the previous rebuild.
-bool connectionsChanged(const std::vector<Connection>& a, const std::vector<Connection>& b)
-{
-    if (a.size() != b.size()) {
-        return true;
+    glBindBuffer(target, buffer);
+    if (data.size() > static_cast<size_t>(capacity)) {
+        capacity = std::max(static_cast<int>(data.size()), capacity * 2);
+        glBufferData(target, static_cast<GLsizeiptr>(static_cast<size_t>(capacity) * sizeof(T)),
+                     nullptr, GL_DYNAMIC_DRAW);
+        first = 0;
+        count = data.size();
     }
-
-    for (size_t i = 0; i < a.size(); ++i) {
-        if (a[i].from_id != b[i].from_id || a[i].to_id != b[i].to_id) {
-            return true;
-        }
+    if (count > 0) {
+        glBufferSubData(target, static_cast<GLintptr>(first * sizeof(T)),
+                        static_cast<GLsizeiptr>(count * sizeof(T)), data.data() + first);
     }
-
-    return false;
+    glBindBuffer(target, 0);
 }
 
-/// Return true if component positions changed since the previous rebuild.
-bool positionsChanged(const std::vector<Component>& components,
-                      const std::vector<glm::vec3>& cachedPositions)
+/// Upload the items listed in dirty, each itemSize elements long, merging
+/// runs of consecutive items into one call. dirty is sorted in place.
+template <typename T>
+void uploadDirtyItems(GLenum target, GLuint buffer, int& capacity, const std::vector<T>& data,
+                      std::vector<uint32_t>& dirty, size_t itemSize)
 {
-    if (components.size() != cachedPositions.size()) {
-        return true;
-    }
-
-    for (size_t i = 0; i < components.size(); ++i) {
-        if (componentPosition(components[i]) != cachedPositions[i]) {
-            return true;
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    size_t i = 0;
+    while (i < dirty.size()) {
+        const uint32_t first = dirty[i];
+        uint32_t last = first;
+        while (i + 1 < dirty.size() && dirty[i + 1] == last + 1) {
+            last = dirty[++i];
         }
+        ++i;
+        uploadRange(target, buffer, capacity, data,
+                    first * itemSize, (static_cast<size_t>(last - first) + 1) * itemSize);
     }
-
-    return false;
-}
-
-/// Append one position-only vertex to the CPU-side strip buffer.
-void appendVertex(std::vector<float>& vertices, const glm::vec3& position)
-{
-    vertices.push_back(position.x);
-    vertices.push_back(position.y);
-    vertices.push_back(position.z);
+    dirty.clear();
 }
 
 /// Build one stable cross-section frame without normalizing a near-zero tangent.
@@ -182,24 +190,22 @@ void buildFrame(const glm::vec3& P0, const glm::vec3& P1,
     normal = glm::cross(binormal, tangent);
 }
 
-/// Build one closed tube ring around a Bezier sample point.
-std::vector<glm::vec3> buildRing(const glm::vec3& P0, const glm::vec3& P1,
-                                 const glm::vec3& P2, const glm::vec3& P3, float t,
-                                 glm::vec3& previousTangent)
+/// Write one closed tube ring around a Bezier sample point into the
+/// RING_VERTEX_COUNT vertices starting at ring.
+void writeRing(const glm::vec3& P0, const glm::vec3& P1,
+               const glm::vec3& P2, const glm::vec3& P3, float t,
+               glm::vec3& previousTangent, const glm::vec3& color, WireVertex* ring)
 {
     glm::vec3 normal;
     glm::vec3 binormal;
     buildFrame(P0, P1, P2, P3, t, previousTangent, normal, binormal);
 
     const glm::vec3 center = bezierPoint(P0, P1, P2, P3, t);
-    std::vector<glm::vec3> ring;
-    ring.reserve(static_cast<size_t>(RING_VERTEX_COUNT));
     for (int i = 0; i <= TUBE_SIDES; ++i) {
         const float angle = WIRE_FULL_TURN * static_cast<float>(i) / static_cast<float>(TUBE_SIDES);
         const glm::vec3 radial = std::cos(angle) * normal + std::sin(angle) * binormal;
-        ring.push_back(center + TUBE_RADIUS * radial);
+        ring[i] = {center + TUBE_RADIUS * radial, color};
     }
-    return ring;
 }
 
 } // namespace
@@ -267,10 +273,49 @@ Mesh buildSignalSphere()
     return mesh;
 }
 
+/// Control points of the tube between two component positions.
+void wireControlPoints(const glm::vec3& from, const glm::vec3& to, glm::vec3 points[4])
+{
+    points[0] = from + glm::vec3(WIRE_ZERO, WIRE_ZERO, WIRE_END_OFFS);
+    points[3] = to + glm::vec3(WIRE_ZERO, WIRE_ZERO, -WIRE_END_OFFS);
+    points[1] = points[0] + glm::vec3(WIRE_ZERO, WIRE_CTRL_LIFT, WIRE_ZERO);
+    points[2] = points[3] + glm::vec3(WIRE_ZERO, WIRE_CTRL_LIFT, WIRE_ZERO);
+}
+
+void RowWireLookup::reset(size_t connectionCount)
+{
+    m_wireOfConnection.assign(connectionCount, -1);
+    m_selfLoopWires.clear();
+}
+
+void RowWireLookup::add(size_t connection, uint32_t wire, int fromRow, int toRow)
+{
+    m_wireOfConnection[connection] = static_cast<int32_t>(wire);
+    if (fromRow == toRow) {
+        m_selfLoopWires.emplace(fromRow, wire);
+    }
+}
+
+void RowWireLookup::appendWires(const AdjacencyCSR& adjacency, size_t row, std::vector<uint32_t>& wires) const
+{
+    if (row < static_cast<size_t>(adjacency.nodeCount())) {
+        for (int entry = adjacency.offsets[row]; entry < adjacency.offsets[row + 1]; ++entry) {
+            const size_t connection = static_cast<size_t>(adjacency.edges[static_cast<size_t>(entry)]);
+            if (connection < m_wireOfConnection.size() && m_wireOfConnection[connection] >= 0) {
+                wires.push_back(static_cast<uint32_t>(m_wireOfConnection[connection]));
+            }
+        }
+    }
+    const auto selfLoops = m_selfLoopWires.equal_range(static_cast<int>(row));
+    for (auto it = selfLoops.first; it != selfLoops.second; ++it) {
+        wires.push_back(it->second);
+    }
+}
+
 /// Initialize shaders and signal sphere mesh.
 bool WireRenderer::init()
 {
-    m_wireShader = loadWireShader();
+    m_wireShader = loadWireShader("../shaders/wire.vert", "../shaders/wire.frag");
     if (m_wireShader == 0) {
         return false;
     }
@@ -279,11 +324,50 @@ bool WireRenderer::init()
     m_viewLoc = glGetUniformLocation(m_wireShader, "view");
     m_projectionLoc = glGetUniformLocation(m_wireShader, "projection");
     m_colorLoc = glGetUniformLocation(m_wireShader, "objectColor");
-    if (m_modelLoc == -1 || m_viewLoc == -1 || m_projectionLoc == -1 || m_colorLoc == -1) {
+    m_useVertexColorLoc = glGetUniformLocation(m_wireShader, "uUseVertexColor");
+    if (m_modelLoc == -1 || m_viewLoc == -1 || m_projectionLoc == -1 || m_colorLoc == -1 ||
+        m_useVertexColorLoc == -1) {
         std::cerr << "[Elec3D] WireRenderer: required uniform missing\n";
         return false;
     }
 
+    m_wirePickShader = loadWireShader("../shaders/wire.vert", "../shaders/pick.frag");
+    if (m_wirePickShader == 0) {
+        return false;
+    }
+    m_wirePickModelLoc = glGetUniformLocation(m_wirePickShader, "model");
+    m_wirePickViewLoc = glGetUniformLocation(m_wirePickShader, "view");
+    m_wirePickProjectionLoc = glGetUniformLocation(m_wirePickShader, "projection");
+    m_wirePickIdLoc = glGetUniformLocation(m_wirePickShader, "uPickId");
+    if (m_wirePickModelLoc == -1 || m_wirePickViewLoc == -1 || m_wirePickProjectionLoc == -1 ||
+        m_wirePickIdLoc == -1) {
+        std::cerr << "[Elec3D] WireRenderer: required pick uniform missing\n";
+        return false;
+    }
+
+    glGenVertexArrays(1, &m_wireVao);
+    glGenBuffers(1, &m_wireVbo);
+    glGenBuffers(1, &m_wireEbo);
+    glBindVertexArray(m_wireVao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_wireVbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(WireVertex),
+        reinterpret_cast<void*>(offsetof(WireVertex, position)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(WireVertex),
+        reinterpret_cast<void*>(offsetof(WireVertex, color)));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_wireEbo);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (m_wireVao == 0 || m_wireVbo == 0 || m_wireEbo == 0) {
+        std::cerr << "[Elec3D] WireRenderer: failed to create wire buffers\n";
+        return false;
+    }
+    // Both tessellation modes stay ready; the setting can change at runtime.
+    if (!initTubeTemplate()) {
+        return false;
+    }
+
     m_sphereMesh = buildSignalSphere();
     MeshBuilder::upload(m_sphereMesh);
     if (m_sphereMesh.vao == 0 || m_sphereMesh.vbo == 0 ||
@@ -291,33 +375,197 @@ bool WireRenderer::init()
         std::cerr << "[Elec3D] WireRenderer: failed to upload signal sphere\n";
         return false;
     }
+    if (!initSignalSpheres()) {
+        return false;
+    }
+
+    return true;
+}
+
+/// Load the signal shader and attach the instance buffer to the sphere.
+bool WireRenderer::initSignalSpheres()
+{
+    m_signalShader = loadWireShader("../shaders/signal.vert", "../shaders/wire.frag");
+    if (m_signalShader == 0) {
+        return false;
+    }
+    m_signalViewLoc = glGetUniformLocation(m_signalShader, "view");
+    m_signalProjectionLoc = glGetUniformLocation(m_signalShader, "projection");
+    m_signalTimeLoc = glGetUniformLocation(m_signalShader, "uTime");
+    m_signalSpeedLoc = glGetUniformLocation(m_signalShader, "uSignalSpeed");
+    m_signalRadiusLoc = glGetUniformLocation(m_signalShader, "uSignalRadius");
+    m_signalColorLoc = glGetUniformLocation(m_signalShader, "uSignalColor");
+    if (m_signalViewLoc == -1 || m_signalProjectionLoc == -1 || m_signalTimeLoc == -1 ||
+        m_signalSpeedLoc == -1 || m_signalRadiusLoc == -1 || m_signalColorLoc == -1) {
+        std::cerr << "[Elec3D] WireRenderer: required signal uniform missing\n";
+        return false;
+    }
+
+    // The sphere mesh only fills location 0, so the control points take
+    // locations 1-4 of the same VAO.
+    glGenBuffers(1, &m_signalInstanceVbo);
+    glBindVertexArray(m_sphereMesh.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_signalInstanceVbo);
+    const size_t attributeOffsets[] = {
+        offsetof(SignalInstance, P0), offsetof(SignalInstance, P1),
+        offsetof(SignalInstance, P2), offsetof(SignalInstance, P3),
+    };
+    for (GLuint i = 0; i < 4; ++i) {
+        const GLuint location = i + 1u;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(SignalInstance),
+            reinterpret_cast<void*>(attributeOffsets[i]));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (m_signalInstanceVbo == 0) {
+        std::cerr << "[Elec3D] WireRenderer: failed to create signal instance buffer\n";
+        return false;
+    }
+    return true;
+}
+
+/// Create the template tube and its instance buffer.
+bool WireRenderer::initTubeTemplate()
+{
+    m_tubeShader = loadWireShader("../shaders/wire_tube.vert", "../shaders/wire.frag");
+    if (m_tubeShader == 0) {
+        return false;
+    }
+    m_tubeViewLoc = glGetUniformLocation(m_tubeShader, "view");
+    m_tubeProjectionLoc = glGetUniformLocation(m_tubeShader, "projection");
+    m_tubeRadiusLoc = glGetUniformLocation(m_tubeShader, "uTubeRadius");
+    if (m_tubeViewLoc == -1 || m_tubeProjectionLoc == -1 || m_tubeRadiusLoc == -1) {
+        std::cerr << "[Elec3D] WireRenderer: required tube uniform missing\n";
+        return false;
+    }
+    m_tubePickShader = loadWireShader("../shaders/wire_tube.vert", "../shaders/pick.frag");
+    if (m_tubePickShader == 0) {
+        return false;
+    }
+    m_tubePickViewLoc = glGetUniformLocation(m_tubePickShader, "view");
+    m_tubePickProjectionLoc = glGetUniformLocation(m_tubePickShader, "projection");
+    m_tubePickRadiusLoc = glGetUniformLocation(m_tubePickShader, "uTubeRadius");
+    if (m_tubePickViewLoc == -1 || m_tubePickProjectionLoc == -1 || m_tubePickRadiusLoc == -1) {
+        std::cerr << "[Elec3D] WireRenderer: required tube pick uniform missing\n";
+        return false;
+    }
+
+    // Ring vertices carry only where they sit on the tube; the shader turns
+    // (t, angle) into a position on each instance's curve.
+    std::vector<float> coords;
+    coords.reserve(static_cast<size_t>(WIRE_VERTEX_COUNT * 2));
+    for (int segment = 0; segment <= WIRE_SEGMENTS; ++segment) {
+        const float t = static_cast<float>(segment) / static_cast<float>(WIRE_SEGMENTS);
+        for (int side = 0; side <= TUBE_SIDES; ++side) {
+            coords.push_back(t);
+            coords.push_back(WIRE_FULL_TURN * static_cast<float>(side) / static_cast<float>(TUBE_SIDES));
+        }
+    }
+    std::vector<uint32_t> indices;
+    indices.reserve(static_cast<size_t>(WIRE_INDEX_COUNT));
+    for (int segment = 0; segment < WIRE_SEGMENTS; ++segment) {
+        const uint32_t ring = static_cast<uint32_t>(segment * RING_VERTEX_COUNT);
+        for (int side = 0; side < RING_VERTEX_COUNT; ++side) {
+            indices.push_back(ring + static_cast<uint32_t>(side));
+            indices.push_back(ring + static_cast<uint32_t>(RING_VERTEX_COUNT + side));
+        }
+        indices.push_back(WIRE_RESTART_INDEX);
+    }
+    m_tubeIndexCount = static_cast<int>(indices.size());
+
+    glGenVertexArrays(1, &m_tubeVao);
+    glGenBuffers(1, &m_tubeVbo);
+    glGenBuffers(1, &m_tubeEbo);
+    glGenBuffers(1, &m_tubeInstanceVbo);
+    glBindVertexArray(m_tubeVao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_tubeVbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(coords.size() * sizeof(float)),
+                 coords.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_tubeEbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(uint32_t)),
+                 indices.data(), GL_STATIC_DRAW);
 
+    glBindBuffer(GL_ARRAY_BUFFER, m_tubeInstanceVbo);
+    const size_t attributeOffsets[] = {
+        offsetof(WireInstance, P0), offsetof(WireInstance, P1),
+        offsetof(WireInstance, P2), offsetof(WireInstance, P3),
+        offsetof(WireInstance, color),
+    };
+    for (GLuint i = 0; i < 5; ++i) {
+        const GLuint location = i + 1u;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(WireInstance),
+            reinterpret_cast<void*>(attributeOffsets[i]));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glVertexAttribIPointer(6, 1, GL_INT, sizeof(WireInstance),
+        reinterpret_cast<void*>(offsetof(WireInstance, connection)));
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (m_tubeVao == 0 || m_tubeVbo == 0 || m_tubeEbo == 0 || m_tubeInstanceVbo == 0) {
+        std::cerr << "[Elec3D] WireRenderer: failed to create tube template\n";
+        return false;
+    }
     return true;
 }
 
 /// Draw all wire tubes and active signal spheres.
-void WireRenderer::draw(const std::vector<Connection>& connections,
-                        const std::vector<Component>& components,
+void WireRenderer::draw(const CircuitGraph& graph,
                         float elapsedTime,
                         const glm::mat4& view,
                         const glm::mat4& projection,
                         const glm::vec3& viewPos)
 {
     (void)viewPos;
-    if (connectionsChanged(connections, m_cachedConnections) ||
-        positionsChanged(components, m_cachedPositions)) {
-        markDirty();
-    }
-
-    if (m_wiresDirty) {
-        rebuildWireMeshes(connections, components);
-        m_cachedConnections = connections;
-        m_cachedPositions.clear();
-        m_cachedPositions.reserve(components.size());
-        for (const auto& component : components) {
-            m_cachedPositions.push_back(componentPosition(component));
+    if (gpuWireTessellation != m_gpuTessellation) {
+        switchTessellationMode();
+    }
+    // A topology change can move loop membership anywhere, so it re-lists
+    // every wire; a component edit only re-places the wires it touches.
+    // Neither version moving means nothing to do.
+    // While a build is in flight, edits wait for it: the first frame after
+    // it lands diffs positions against the state it was built from.
+    if (m_pendingBuild &&
+        m_pendingBuild->done.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        applyWireBuild(*m_pendingBuild);
+        m_pendingBuild.reset();
+    }
+    if (!m_pendingBuild) {
+        if (m_wiresDirty || graph.topologyVersion() != m_cachedTopologyVersion) {
+            rebuildWireMeshes(graph, graph.cycleAnalysis().loopedComponents);
+            m_cachedTopologyVersion = graph.topologyVersion();
+            m_cachedComponentRevision = graph.componentRevision();
+            m_wiresDirty = false;
+        } else if (graph.componentRevision() != m_cachedComponentRevision) {
+            updateMovedWires(graph);
+            m_cachedComponentRevision = graph.componentRevision();
         }
-        m_wiresDirty = false;
+    }
+    uploadPendingVertices();
+    if (m_wireIndicesDirty || visibleLayers != m_indexedLayers) {
+        rebuildWireIndices();
+    }
+    if (m_signalsDirty || signalEnabledRevision != m_signalRevision) {
+        rebuildSignalInstances();
+    }
+
+    if (m_gpuTessellation && !m_wireInstances.empty()) {
+        glUseProgram(m_tubeShader);
+        glUniformMatrix4fv(m_tubeViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(m_tubeProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1f(m_tubeRadiusLoc, TUBE_RADIUS);
+        glBindVertexArray(m_tubeVao);
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(WIRE_RESTART_INDEX);
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP, m_tubeIndexCount, GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(m_wireInstances.size()));
+        glDisable(GL_PRIMITIVE_RESTART);
     }
 
     glUseProgram(m_wireShader);
@@ -326,53 +574,91 @@ void WireRenderer::draw(const std::vector<Connection>& connections,
 
     const glm::mat4 model = glm::mat4(WIRE_ONE);
     glUniformMatrix4fv(m_modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniform3fv(m_colorLoc, 1, glm::value_ptr(INACTIVE_WIRE_COLOR));
 
-    const std::unordered_set<int> loopedSet = FindLoopedComponents(components, connections);
-    for (size_t i = 0; i < m_wireMeshes.size() && i < connections.size(); ++i) {
-        const Component* from = findComponent(components, connections[i].from_id);
-        const Component* to = findComponent(components, connections[i].to_id);
-        if (!from || !to) {
-            continue;
-        }
-        if (!loopedSet.count(from->id) || !loopedSet.count(to->id)) {
-            continue;
-        }
-        if (!visibleLayers.count(from->layer) || !visibleLayers.count(to->layer)) {
-            continue;
-        }
+    // Every visible tube in one call: each segment is a strip, and the
+    // restart index separates strips inside the merged index buffer. While
+    // a rebuild is still streaming in, only the wires already uploaded are
+    // drawn; they are always a prefix of the list.
+    const size_t uploadedWires =
+        std::min(m_uploadedVertexCount / static_cast<size_t>(WIRE_VERTEX_COUNT), m_wires.size());
+    const size_t drawnIndexCount =
+        uploadedWires < m_wireIndexOffsets.size() ? m_wireIndexOffsets[uploadedWires] : 0;
+    if (!m_gpuTessellation && drawnIndexCount > 0) {
+        glUniform1i(m_useVertexColorLoc, 1);
+        glBindVertexArray(m_wireVao);
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(WIRE_RESTART_INDEX);
+        glDrawElements(GL_TRIANGLE_STRIP, static_cast<GLsizei>(drawnIndexCount),
+                       GL_UNSIGNED_INT, nullptr);
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+    glUniform1i(m_useVertexColorLoc, 0);
 
-        const auto& wireMesh = m_wireMeshes[i];
-        glBindVertexArray(wireMesh.vao);
-        for (int segment = 0; segment < WIRE_SEGMENTS; ++segment) {
-            glDrawArrays(GL_TRIANGLE_STRIP,
-                         segment * STRIP_VERTEX_COUNT,
-                         STRIP_VERTEX_COUNT);
+    drawSignalSpheres(elapsedTime, view, projection);
+    glBindVertexArray(0);
+}
+
+/// Draw every drawn tube into the bound ID buffer.
+void WireRenderer::drawPickIds(const glm::mat4& view, const glm::mat4& projection)
+{
+    if (m_gpuTessellation) {
+        if (m_wireInstances.empty()) {
+            return;
         }
+        // The instances already carry their connection; one call as in draw().
+        glUseProgram(m_tubePickShader);
+        glUniformMatrix4fv(m_tubePickViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(m_tubePickProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1f(m_tubePickRadiusLoc, TUBE_RADIUS);
+        glBindVertexArray(m_tubeVao);
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(WIRE_RESTART_INDEX);
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP, m_tubeIndexCount, GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(m_wireInstances.size()));
+        glDisable(GL_PRIMITIVE_RESTART);
+        glBindVertexArray(0);
+        return;
     }
 
-    for (size_t i = 0; i < connections.size() && i < m_bezierCache.size(); ++i) {
-        const Component* from = findComponent(components, connections[i].from_id);
-        const Component* to = findComponent(components, connections[i].to_id);
-        if (!from || !to) {
-            continue;
-        }
-        if (!loopedSet.count(from->id) || !loopedSet.count(to->id)) {
-            continue;
-        }
-        if (!visibleLayers.count(from->layer) || !visibleLayers.count(to->layer)) {
+    // Merged vertices carry no connection, so each tube's index range goes
+    // out on its own with the ID as a uniform. Only the uploaded prefix is
+    // drawn, as in draw(). While a rebuild is in flight the tubes still
+    // carry the previous topology's connection indices, so none are written.
+    if (m_pendingBuild) {
+        return;
+    }
+    const size_t uploadedWires =
+        std::min(m_uploadedVertexCount / static_cast<size_t>(WIRE_VERTEX_COUNT), m_wires.size());
+    if (uploadedWires >= m_wireIndexOffsets.size() || m_wireIndexOffsets[uploadedWires] == 0) {
+        return;
+    }
+    glUseProgram(m_wirePickShader);
+    glUniformMatrix4fv(m_wirePickViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(m_wirePickProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    const glm::mat4 model = glm::mat4(WIRE_ONE);
+    glUniformMatrix4fv(m_wirePickModelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glBindVertexArray(m_wireVao);
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(WIRE_RESTART_INDEX);
+    for (size_t w = 0; w < uploadedWires; ++w) {
+        const size_t first = m_wireIndexOffsets[w];
+        const size_t count = m_wireIndexOffsets[w + 1] - first;
+        if (count == 0) {
             continue;
         }
-
-        const int connKey = connections[i].from_id * CONNECTION_KEY_SCALE + connections[i].to_id;
-        if (signalEnabled[connKey]) {
-            drawSignalSphere(m_bezierCache[i], elapsedTime, view, projection);
-        }
+        glUniform1ui(m_wirePickIdLoc, PICK_ID_WIRE_BIT | static_cast<uint32_t>(m_wires[w].connection + 1));
+        glDrawElements(GL_TRIANGLE_STRIP, static_cast<GLsizei>(count), GL_UNSIGNED_INT,
+                       reinterpret_cast<void*>(first * sizeof(uint32_t)));
     }
-
+    glDisable(GL_PRIMITIVE_RESTART);
     glBindVertexArray(0);
 }
 
+bool WireRenderer::wiresCurrent() const
+{
+    return !m_pendingBuild && m_uploadedVertexCount >= m_wireVertices.size();
+}
+
 /// Mark wire geometry as needing rebuild next draw call.
 void WireRenderer::markDirty()
 {
@@ -382,18 +668,56 @@ void WireRenderer::markDirty()
 /// Free all GPU resources.
 void WireRenderer::shutdown()
 {
-    for (auto& wireMesh : m_wireMeshes) {
-        if (wireMesh.vbo != 0) {
-            glDeleteBuffers(1, &wireMesh.vbo);
-            wireMesh.vbo = 0;
-        }
-        if (wireMesh.vao != 0) {
-            glDeleteVertexArrays(1, &wireMesh.vao);
-            wireMesh.vao = 0;
+    if (m_pendingBuild) {
+        m_pendingBuild->done.wait();
+        m_pendingBuild.reset();
+    }
+    if (m_signalInstanceVbo != 0) {
+        glDeleteBuffers(1, &m_signalInstanceVbo);
+        m_signalInstanceVbo = 0;
+    }
+    if (m_signalShader != 0) {
+        glDeleteProgram(m_signalShader);
+        m_signalShader = 0;
+    }
+    m_signalInstances.clear();
+    const GLuint tubeBuffers[] = {m_tubeInstanceVbo, m_tubeEbo, m_tubeVbo};
+    for (GLuint buffer : tubeBuffers) {
+        if (buffer != 0) {
+            glDeleteBuffers(1, &buffer);
         }
     }
-    m_wireMeshes.clear();
-    m_bezierCache.clear();
+    m_tubeInstanceVbo = 0;
+    m_tubeEbo = 0;
+    m_tubeVbo = 0;
+    if (m_tubeVao != 0) {
+        glDeleteVertexArrays(1, &m_tubeVao);
+        m_tubeVao = 0;
+    }
+    if (m_tubeShader != 0) {
+        glDeleteProgram(m_tubeShader);
+        m_tubeShader = 0;
+    }
+    if (m_tubePickShader != 0) {
+        glDeleteProgram(m_tubePickShader);
+        m_tubePickShader = 0;
+    }
+    m_wireInstances.clear();
+    if (m_wireEbo != 0) {
+        glDeleteBuffers(1, &m_wireEbo);
+        m_wireEbo = 0;
+    }
+    if (m_wireVbo != 0) {
+        glDeleteBuffers(1, &m_wireVbo);
+        m_wireVbo = 0;
+    }
+    if (m_wireVao != 0) {
+        glDeleteVertexArrays(1, &m_wireVao);
+        m_wireVao = 0;
+    }
+    m_wires.clear();
+    m_wireVertices.clear();
+    m_wireIndices.clear();
 
     if (m_sphereMesh.ebo != 0) {
         glDeleteBuffers(1, &m_sphereMesh.ebo);
@@ -411,95 +735,405 @@ void WireRenderer::shutdown()
         glDeleteProgram(m_wireShader);
         m_wireShader = 0;
     }
+    if (m_wirePickShader != 0) {
+        glDeleteProgram(m_wirePickShader);
+        m_wirePickShader = 0;
+    }
 }
 
-/// Rebuild tube VBOs for the current connection list.
-void WireRenderer::rebuildWireMeshes(const std::vector<Connection>& connections,
-                                     const std::vector<Component>& components)
+/// Rebuild the wire list after a topology change.
+void WireRenderer::rebuildWireMeshes(const CircuitGraph& graph, const std::unordered_set<int>& loopedSet)
 {
-    for (auto& wireMesh : m_wireMeshes) {
-        if (wireMesh.vbo != 0) {
-            glDeleteBuffers(1, &wireMesh.vbo);
+    auto build = std::make_unique<WireBuild>();
+    const ComponentStore& store = graph.componentStore();
+    const ComponentRenderColumns& columns = store.render();
+    build->positions.resize(store.size());
+    build->layers.resize(store.size());
+    for (size_t row = 0; row < store.size(); ++row) {
+        build->positions[row] = rowPosition(columns, row);
+        build->layers[row] = columns.layer[row];
+    }
+
+    // Surviving connections usually keep their curve (a connect or delete
+    // elsewhere), so their rings are copied rather than tessellated again.
+    std::unordered_map<ConnectionKey, size_t> previousByKey;
+    if (!m_gpuTessellation) {
+        previousByKey.reserve(m_wires.size());
+        for (size_t i = 0; i < m_wires.size(); ++i) {
+            previousByKey.emplace(m_wires[i].key, i);
+        }
+    }
+
+    std::vector<WireEntry>& wires = build->wires;
+    build->rowWires.reset(graph.connections.size());
+    build->firstChangedVertex = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i < graph.connections.size(); ++i) {
+        const Connection& connection = graph.connections[i];
+        const int fromRow = graph.indexOf(connection.from_id);
+        const int toRow = graph.indexOf(connection.to_id);
+        if (fromRow < 0 || toRow < 0) {
+            continue;
         }
-        if (wireMesh.vao != 0) {
-            glDeleteVertexArrays(1, &wireMesh.vao);
+
+        WireEntry wire;
+        wire.connection = i;
+        wire.key = MakeConnectionKey(connection);
+        wire.fromRow = fromRow;
+        wire.toRow = toRow;
+        wire.firstVertex = static_cast<uint32_t>(wires.size() * WIRE_VERTEX_COUNT);
+        wire.looped = loopedSet.count(connection.from_id) > 0 && loopedSet.count(connection.to_id) > 0;
+        placeWire(wire, store);
+        build->rowWires.add(i, static_cast<uint32_t>(wires.size()), fromRow, toRow);
+        wires.push_back(wire);
+        if (m_gpuTessellation) {
+            continue;
+        }
+
+        const uint32_t w = static_cast<uint32_t>(wires.size() - 1);
+        const auto previous = previousByKey.find(wire.key);
+        if (previous != previousByKey.end() && m_wires[previous->second].curve == wire.curve) {
+            build->reuse.push_back(w);
+            build->reuseFrom.push_back(m_wires[previous->second].firstVertex);
+            if (m_wires[previous->second].firstVertex == wire.firstVertex &&
+                static_cast<size_t>(wire.firstVertex) + WIRE_VERTEX_COUNT <= m_uploadedVertexCount) {
+                continue;   // the same bytes already sit at this offset on the GPU
+            }
+        } else {
+            build->tessellate.push_back(w);
         }
+        build->firstChangedVertex = std::min(build->firstChangedVertex, static_cast<size_t>(wire.firstVertex));
+    }
+
+    // Under GPU tessellation the curves alone are the geometry.
+    if (m_gpuTessellation) {
+        applyWireBuild(*build);
+        return;
+    }
+
+    // Tessellate into recycled storage on worker threads. The current
+    // vertices are only read, and nothing writes them until this lands.
+    build->vertices.swap(m_spareVertices);
+    build->vertices.resize(wires.size() * static_cast<size_t>(WIRE_VERTEX_COUNT));
+    WireBuild* target = build.get();
+    const WireVertex* previousVertices = m_wireVertices.data();
+    build->done = std::async(std::launch::async, [target, previousVertices]() {
+        const size_t taskCount = target->reuse.size() + target->tessellate.size();
+        ParallelForChunks(taskCount, ChunkCount(taskCount, MIN_WIRES_PER_CHUNK),
+            [target, previousVertices](size_t, size_t begin, size_t end) {
+                for (size_t task = begin; task < end; ++task) {
+                    if (task < target->reuse.size()) {
+                        const WireVertex* source = previousVertices + target->reuseFrom[task];
+                        const WireEntry& wire = target->wires[target->reuse[task]];
+                        std::copy(source, source + WIRE_VERTEX_COUNT, target->vertices.begin() + wire.firstVertex);
+                    } else {
+                        const WireEntry& wire = target->wires[target->tessellate[task - target->reuse.size()]];
+                        writeWireMesh(wire.curve, INACTIVE_WIRE_COLOR, target->vertices.data() + wire.firstVertex);
+                    }
+                }
+            });
+    });
+    m_pendingBuild = std::move(build);
+}
+
+/// Make a finished build current and schedule its vertex upload.
+void WireRenderer::applyWireBuild(WireBuild& build)
+{
+    m_wires.swap(build.wires);
+    m_cachedPositions.swap(build.positions);
+    m_cachedLayers.swap(build.layers);
+    std::swap(m_rowWires, build.rowWires);
+    m_spareVertices.swap(m_wireVertices);
+    m_wireVertices.swap(build.vertices);
+    m_wireIndicesDirty = true;
+
+    // A buffer that is too small is orphaned and refilled from the start;
+    // otherwise the unchanged prefix stays and the rest streams over it.
+    // The prefix ends where the previous upload got to if that is earlier,
+    // since everything past it never reached the GPU.
+    if (m_wireVertices.size() > static_cast<size_t>(m_wireVertexCapacity)) {
+        m_wireVertexCapacity = std::max(static_cast<int>(m_wireVertices.size()), m_wireVertexCapacity * 2);
+        glBindBuffer(GL_ARRAY_BUFFER, m_wireVbo);
+        glBufferData(GL_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(static_cast<size_t>(m_wireVertexCapacity) * sizeof(WireVertex)),
+                     nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_uploadedVertexCount = 0;
+    } else {
+        m_uploadedVertexCount = std::min({m_uploadedVertexCount, build.firstChangedVertex, m_wireVertices.size()});
+    }
+}
+
+/// Drop the wires built for the previous tessellation mode.
+void WireRenderer::switchTessellationMode()
+{
+    // The worker reads the current vertices, so they are only released
+    // once it has finished.
+    if (m_pendingBuild) {
+        m_pendingBuild->done.wait();
+        m_pendingBuild.reset();
+    }
+    m_gpuTessellation = gpuWireTessellation;
+
+    // Nothing carries over: CPU builds would copy rings the GPU mode never
+    // wrote, and the instance list would outlive its wires.
+    m_wires.clear();
+    m_wireVertices.clear();
+    m_uploadedVertexCount = 0;
+    m_wireIndices.clear();
+    m_wireIndexOffsets.clear();
+    m_wireInstances.clear();
+    m_wireInstanceIndex.clear();
+    m_wiresDirty = true;
+    m_wireIndicesDirty = true;
+}
+
+/// Upload the next slice of not-yet-uploaded wire vertices.
+void WireRenderer::uploadPendingVertices()
+{
+    if (m_uploadedVertexCount >= m_wireVertices.size()) {
+        return;
+    }
+    const size_t count = std::min(WIRE_UPLOAD_VERTICES_PER_FRAME, m_wireVertices.size() - m_uploadedVertexCount);
+    const GLintptr offset = static_cast<GLintptr>(m_uploadedVertexCount * sizeof(WireVertex));
+    const GLsizeiptr size = static_cast<GLsizeiptr>(count * sizeof(WireVertex));
+    const WireVertex* source = m_wireVertices.data() + m_uploadedVertexCount;
+
+    // Nothing drawn reads this range yet, so the driver may hand out fresh
+    // memory instead of waiting for the GPU.
+    glBindBuffer(GL_ARRAY_BUFFER, m_wireVbo);
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (mapped) {
+        std::memcpy(mapped, source, static_cast<size_t>(size));
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, offset, size, source);
     }
-    m_wireMeshes.clear();
-    m_bezierCache.clear();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_uploadedVertexCount += count;
+}
 
-    for (const auto& connection : connections) {
-        const Component* from = findComponent(components, connection.from_id);
-        const Component* to = findComponent(components, connection.to_id);
-        if (!from || !to) {
+/// Re-place only the wires touching components that moved or changed layer.
+void WireRenderer::updateMovedWires(const CircuitGraph& graph)
+{
+    const ComponentStore& store = graph.componentStore();
+    const ComponentRenderColumns& columns = store.render();
+    const AdjacencyCSR& adjacency = graph.adjacency();
+
+    // Only rows the store logged as edited can have moved; without a log
+    // answer every row is compared against the cached state.
+    m_editedRows.clear();
+    const bool logged = store.editedRowsSince(m_cachedComponentRevision, m_editedRows);
+    const size_t rowCount = std::min(store.size(), m_cachedPositions.size());
+    const size_t checkCount = logged ? m_editedRows.size() : rowCount;
+    std::vector<uint32_t> touched;
+    for (size_t i = 0; i < checkCount; ++i) {
+        const size_t row = logged ? m_editedRows[i] : i;
+        if (row >= rowCount) {
+            continue;
+        }
+        const glm::vec3 position = rowPosition(columns, row);
+        if (position == m_cachedPositions[row] && columns.layer[row] == m_cachedLayers[row]) {
             continue;
         }
+        m_cachedPositions[row] = position;
+        m_cachedLayers[row] = columns.layer[row];
+        m_rowWires.appendWires(adjacency, row, touched);
+    }
+    if (touched.empty()) {
+        return;
+    }
 
-        BezierParams bp;
-        bp.P0 = componentPosition(*from) + glm::vec3(WIRE_ZERO, WIRE_ZERO, WIRE_END_OFFS);
-        bp.P3 = componentPosition(*to) + glm::vec3(WIRE_ZERO, WIRE_ZERO, -WIRE_END_OFFS);
-        bp.P1 = bp.P0 + glm::vec3(WIRE_ZERO, WIRE_CTRL_LIFT, WIRE_ZERO);
-        bp.P2 = bp.P3 + glm::vec3(WIRE_ZERO, WIRE_CTRL_LIFT, WIRE_ZERO);
-        m_bezierCache.push_back(bp);
-        WireMesh mesh = uploadWireMesh(bp);
-        if (mesh.vao == 0 || mesh.vbo == 0 || mesh.vertexCount == 0) {
-            std::cerr << "[Elec3D] WireRenderer: failed to upload wire mesh\n";
+    std::vector<uint32_t> dirtyInstances;
+    std::vector<uint32_t> dirtySignals;
+    for (uint32_t w : touched) {
+        WireEntry& wire = m_wires[w];
+        const int fromLayer = wire.fromLayer;
+        const int toLayer = wire.toLayer;
+        placeWire(wire, store);
+        if (wire.fromLayer != fromLayer || wire.toLayer != toLayer) {
+            m_wireIndicesDirty = true;   // visibility may change: re-list the drawn wires
+        }
+        const int signal = w < m_wireSignalIndex.size() ? m_wireSignalIndex[w] : -1;
+        if (signal >= 0) {
+            const BezierParams& bp = wire.curve;
+            m_signalInstances[static_cast<size_t>(signal)] = {bp.P0, bp.P1, bp.P2, bp.P3};
+            dirtySignals.push_back(static_cast<uint32_t>(signal));
+        }
+
+        if (m_gpuTessellation) {
+            const int instance = m_wireInstanceIndex[w];
+            if (instance >= 0) {
+                const BezierParams& bp = wire.curve;
+                m_wireInstances[static_cast<size_t>(instance)] = {
+                    bp.P0, bp.P1, bp.P2, bp.P3, INACTIVE_WIRE_COLOR, static_cast<int32_t>(wire.connection)};
+                dirtyInstances.push_back(static_cast<uint32_t>(instance));
+            }
         }
-        m_wireMeshes.push_back(mesh);
     }
+
+    if (!m_gpuTessellation) {
+        // A bulk move can touch thousands of wires; each one only writes
+        // its own vertex range, so they tessellate in parallel.
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        ParallelForChunks(touched.size(), ChunkCount(touched.size(), MIN_WIRES_PER_CHUNK),
+            [this, &touched](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const WireEntry& wire = m_wires[touched[i]];
+                    writeWireMesh(wire.curve, INACTIVE_WIRE_COLOR, m_wireVertices.data() + wire.firstVertex);
+                }
+            });
+    }
+
+    if (!m_wireIndicesDirty && !dirtySignals.empty()) {
+        uploadDirtyItems(GL_ARRAY_BUFFER, m_signalInstanceVbo, m_signalInstanceCapacity,
+                         m_signalInstances, dirtySignals, 1);
+    }
+
+    if (m_gpuTessellation) {
+        if (!m_wireIndicesDirty) {
+            uploadDirtyItems(GL_ARRAY_BUFFER, m_tubeInstanceVbo, m_wireInstanceCapacity,
+                             m_wireInstances, dirtyInstances, 1);
+        }
+        return;
+    }
+    uploadDirtyItems(GL_ARRAY_BUFFER, m_wireVbo, m_wireVertexCapacity, m_wireVertices,
+                     touched, static_cast<size_t>(WIRE_VERTEX_COUNT));
 }
 
-/// Upload one Bezier tube mesh to a VAO/VBO pair.
-WireRenderer::WireMesh WireRenderer::uploadWireMesh(const BezierParams& bp)
+/// Set a wire's curve and layers from its endpoints' current rows.
+void WireRenderer::placeWire(WireEntry& wire, const ComponentStore& store) const
 {
-    std::vector<std::vector<glm::vec3>> rings;
-    rings.reserve(static_cast<size_t>(WIRE_SEGMENTS + 1));
+    const ComponentRenderColumns& columns = store.render();
+    const size_t fromRow = static_cast<size_t>(wire.fromRow);
+    const size_t toRow = static_cast<size_t>(wire.toRow);
+    wire.fromLayer = columns.layer[fromRow];
+    wire.toLayer = columns.layer[toRow];
 
+    glm::vec3 points[4];
+    wireControlPoints(rowPosition(columns, fromRow), rowPosition(columns, toRow), points);
+    wire.curve = {points[0], points[1], points[2], points[3]};
+}
+
+/// Write one Bezier tube's rings into vertices.
+void WireRenderer::writeWireMesh(const BezierParams& bp, const glm::vec3& color, WireVertex* vertices)
+{
     glm::vec3 previousTangent(WIRE_ZERO, WIRE_ZERO, WIRE_ONE);
     for (int segment = 0; segment <= WIRE_SEGMENTS; ++segment) {
         const float t = static_cast<float>(segment) / static_cast<float>(WIRE_SEGMENTS);
-        rings.push_back(buildRing(bp.P0, bp.P1, bp.P2, bp.P3, t, previousTangent));
+        writeRing(bp.P0, bp.P1, bp.P2, bp.P3, t, previousTangent, color,
+                  vertices + static_cast<size_t>(segment * RING_VERTEX_COUNT));
     }
+}
 
-    std::vector<float> vertices;
-    vertices.reserve(static_cast<size_t>(WIRE_SEGMENTS * STRIP_VERTEX_COUNT * POSITION_FLOAT_COUNT));
-    for (int segment = 0; segment < WIRE_SEGMENTS; ++segment) {
-        for (int side = 0; side < RING_VERTEX_COUNT; ++side) {
-            appendVertex(vertices, rings[static_cast<size_t>(segment)][static_cast<size_t>(side)]);
-            appendVertex(vertices, rings[static_cast<size_t>(segment + 1)][static_cast<size_t>(side)]);
+/// Rebuild the draw list from the wires visible on the current layers.
+void WireRenderer::rebuildWireIndices()
+{
+    m_signalsDirty = true;   // the spheres follow the drawn wires
+    if (m_gpuTessellation) {
+        m_wireInstances.clear();
+        m_wireInstanceIndex.assign(m_wires.size(), -1);
+        for (size_t w = 0; w < m_wires.size(); ++w) {
+            const WireEntry& wire = m_wires[w];
+            if (!wire.looped) {
+                continue;
+            }
+            if (!visibleLayers.count(wire.fromLayer) || !visibleLayers.count(wire.toLayer)) {
+                continue;
+            }
+            const BezierParams& bp = wire.curve;
+            m_wireInstanceIndex[w] = static_cast<int>(m_wireInstances.size());
+            m_wireInstances.push_back({bp.P0, bp.P1, bp.P2, bp.P3, INACTIVE_WIRE_COLOR,
+                                       static_cast<int32_t>(wire.connection)});
         }
+        uploadRange(GL_ARRAY_BUFFER, m_tubeInstanceVbo, m_wireInstanceCapacity, m_wireInstances,
+                    0, m_wireInstances.size());
+        m_indexedLayers = visibleLayers;
+        m_wireIndicesDirty = false;
+        return;
     }
 
-    WireMesh mesh;
-    mesh.vertexCount = static_cast<int>(vertices.size() / POSITION_FLOAT_COUNT);
-    glGenVertexArrays(1, &mesh.vao);
-    glGenBuffers(1, &mesh.vbo);
-    glBindVertexArray(mesh.vao);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(vertices.size() * sizeof(float)),
-                 vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_wireIndices.clear();
+    m_wireIndices.reserve(m_wires.size() * static_cast<size_t>(WIRE_INDEX_COUNT));
+    m_wireIndexOffsets.resize(m_wires.size() + 1);
+    for (size_t w = 0; w < m_wires.size(); ++w) {
+        const WireEntry& wire = m_wires[w];
+        m_wireIndexOffsets[w] = m_wireIndices.size();
+        if (!wire.looped) {
+            continue;
+        }
+        if (!visibleLayers.count(wire.fromLayer) || !visibleLayers.count(wire.toLayer)) {
+            continue;
+        }
+
+        // Same strips the per-segment draws used to issue: ring s and ring
+        // s + 1 interleaved side by side, closed by a restart index.
+        for (int segment = 0; segment < WIRE_SEGMENTS; ++segment) {
+            const uint32_t ring = wire.firstVertex + static_cast<uint32_t>(segment * RING_VERTEX_COUNT);
+            for (int side = 0; side < RING_VERTEX_COUNT; ++side) {
+                m_wireIndices.push_back(ring + static_cast<uint32_t>(side));
+                m_wireIndices.push_back(ring + static_cast<uint32_t>(RING_VERTEX_COUNT + side));
+            }
+            m_wireIndices.push_back(WIRE_RESTART_INDEX);
+        }
+    }
+    m_wireIndexOffsets.back() = m_wireIndices.size();
+
+    // The element buffer binding is VAO state, so upload through the VAO.
+    glBindVertexArray(m_wireVao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(m_wireIndices.size() * sizeof(uint32_t)),
+                 m_wireIndices.data(), GL_DYNAMIC_DRAW);
     glBindVertexArray(0);
-    return mesh;
+    m_indexedLayers = visibleLayers;
+    m_wireIndicesDirty = false;
 }
 
-/// Draw one animated signal sphere on a cached Bezier curve.
-void WireRenderer::drawSignalSphere(const BezierParams& bp, float elapsedTime,
-                                    const glm::mat4& view, const glm::mat4& projection)
+/// Re-list the signal sphere instances from the drawn wires and toggles.
+void WireRenderer::rebuildSignalInstances()
 {
-    const float t = std::fmod(elapsedTime * SIGNAL_SPEED, WIRE_ONE);
-    const glm::vec3 position = bezierPoint(bp.P0, bp.P1, bp.P2, bp.P3, t);
-    glm::mat4 model = glm::translate(glm::mat4(WIRE_ONE), position);
-    model = glm::scale(model, glm::vec3(SIGNAL_RADIUS));
+    m_signalInstances.clear();
+    m_wireSignalIndex.assign(m_wires.size(), -1);
+    for (size_t w = 0; w < m_wires.size(); ++w) {
+        const WireEntry& wire = m_wires[w];
+        if (!wire.looped) {
+            continue;
+        }
+        if (!visibleLayers.count(wire.fromLayer) || !visibleLayers.count(wire.toLayer)) {
+            continue;
+        }
 
-    glUseProgram(m_wireShader);
-    glUniformMatrix4fv(m_modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(m_viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(m_projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform3fv(m_colorLoc, 1, glm::value_ptr(SIGNAL_COLOR));
+        // The key, not the connection index: during a rebuild these wires
+        // may describe an older connection list than graph's.
+        const auto enabled = signalEnabled.find(wire.key);
+        if (enabled == signalEnabled.end() || !enabled->second) {
+            continue;
+        }
+        const BezierParams& bp = wire.curve;
+        m_wireSignalIndex[w] = static_cast<int>(m_signalInstances.size());
+        m_signalInstances.push_back({bp.P0, bp.P1, bp.P2, bp.P3});
+    }
+    uploadRange(GL_ARRAY_BUFFER, m_signalInstanceVbo, m_signalInstanceCapacity, m_signalInstances,
+                0, m_signalInstances.size());
+    m_signalRevision = signalEnabledRevision;
+    m_signalsDirty = false;
+}
+
+/// Draw every enabled signal sphere in one instanced call.
+void WireRenderer::drawSignalSpheres(float elapsedTime, const glm::mat4& view, const glm::mat4& projection)
+{
+    if (m_signalInstances.empty()) {
+        return;
+    }
+    glUseProgram(m_signalShader);
+    glUniformMatrix4fv(m_signalViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(m_signalProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1f(m_signalTimeLoc, elapsedTime);
+    glUniform1f(m_signalSpeedLoc, SIGNAL_SPEED);
+    glUniform1f(m_signalRadiusLoc, SIGNAL_RADIUS);
+    glUniform3fv(m_signalColorLoc, 1, glm::value_ptr(SIGNAL_COLOR));
     glBindVertexArray(m_sphereMesh.vao);
-    glDrawElements(GL_TRIANGLES, m_sphereMesh.indexCount, GL_UNSIGNED_INT, nullptr);
+    glDrawElementsInstanced(GL_TRIANGLES, m_sphereMesh.indexCount, GL_UNSIGNED_INT, nullptr,
+                            static_cast<GLsizei>(m_signalInstances.size()));
 }
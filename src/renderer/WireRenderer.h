@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <glad/glad.h>
@@ -27,6 +33,28 @@ constexpr float WIRE_PI = 3.14159265358979323846f;
 constexpr float WIRE_FULL_TURN = WIRE_TWO * WIRE_PI;
 constexpr float WIRE_TANGENT_EPSILON = 1e-4f;
 constexpr float WIRE_UP_DOT_LIMIT = 0.99f;
+constexpr uint32_t WIRE_RESTART_INDEX = 0xFFFFFFFFu;   // ends one triangle strip in the merged index buffer
+
+/// One vertex of the merged wire buffer. Color is per vertex so every tube
+/// can go out in the same draw call.
+struct WireVertex {
+    glm::vec3 position;
+    glm::vec3 color;
+};
+
+/// Per-wire data for GPU tessellation: the vertex shader bends a shared
+/// template tube along these control points.
+struct WireInstance {
+    glm::vec3 P0, P1, P2, P3;
+    glm::vec3 color;
+    int32_t connection;   // index into graph.connections, for the ID buffer
+};
+
+/// Per-sphere data for the signal pulses: signal.vert moves the sphere
+/// along these control points from the time uniform alone.
+struct SignalInstance {
+    glm::vec3 P0, P1, P2, P3;
+};
 
 /// Evaluate a cubic Bezier curve at parameter t in [0, 1].
 glm::vec3 bezierPoint(
@@ -43,19 +71,52 @@ glm::vec3 bezierTangent(
 /// Build a UV sphere centered at origin, radius 1.0.
 Mesh buildSignalSphere();
 
+/// Control points of the tube between two component positions: each end
+/// steps off along z and the inner points lift above it. WireRenderer draws
+/// along this curve and ScenePicker tests rays against it.
+void wireControlPoints(const glm::vec3& from, const glm::vec3& to, glm::vec3 points[4]);
+
+/// Finds the wires touching a store row through the graph's cached
+/// adjacency, so no row-to-wire table has to be built next to it.
+/// Self-connections are not in the adjacency and are kept here by row.
+class RowWireLookup {
+public:
+    /// Starts over for a list of connectionCount connections.
+    void reset(size_t connectionCount);
+
+    /// Records that connection is drawn as wire between the two rows.
+    void add(size_t connection, uint32_t wire, int fromRow, int toRow);
+
+    /// Appends the wires touching row to wires. adjacency must describe the
+    /// topology the wires were added for.
+    void appendWires(const AdjacencyCSR& adjacency, size_t row, std::vector<uint32_t>& wires) const;
+
+private:
+    std::vector<int32_t> m_wireOfConnection;                  // -1 for a connection with no wire
+    std::unordered_multimap<int, uint32_t> m_selfLoopWires;   // row -> wire
+};
+
 class WireRenderer {
 public:
     /// Initialize shaders and signal sphere mesh.
     bool init();
 
-    /// Draw all wire tubes and active signal spheres.
-    void draw(const std::vector<Connection>& connections,
-              const std::vector<Component>& components,
+    /// Draw all wire tubes and active signal spheres. Loop membership is
+    /// only asked of the graph when a topology change re-lists the wires.
+    void draw(const CircuitGraph& graph,
               float elapsedTime,
               const glm::mat4& view,
               const glm::mat4& projection,
               const glm::vec3& viewPos);
 
+    /// Draw every drawn tube into the bound ID buffer, each writing its
+    /// connection's pick ID. Call after draw() in the same frame.
+    void drawPickIds(const glm::mat4& view, const glm::mat4& projection);
+
+    /// True when the tubes on the GPU match the graph last passed to
+    /// draw(): no rebuild is in flight and every vertex is uploaded.
+    bool wiresCurrent() const;
+
     /// Mark wire geometry as needing rebuild next draw call.
     void markDirty();
 
@@ -63,37 +124,169 @@ public:
     void shutdown();
 
 private:
+    // When true, tubes are one instanced template mesh bent along each
+    // wire's control points in wire_tube.vert; when false, every tube is
+    // tessellated on the CPU into the merged vertex buffer. Follows the
+    // gpuWireTessellation setting; the wires below were built for this mode.
+    bool m_gpuTessellation = true;
+
     GLuint m_wireShader = 0;
+    GLuint m_wirePickShader = 0;   // wire.vert with pick.frag, one draw per tube
     Mesh m_sphereMesh;
     bool m_wiresDirty = true;
 
-    struct WireMesh {
-        GLuint vao = 0;
-        GLuint vbo = 0;
-        int vertexCount = 0;
-    };
-    std::vector<WireMesh> m_wireMeshes;
-
     struct BezierParams {
         glm::vec3 P0, P1, P2, P3;
+
+        bool operator==(const BezierParams& other) const
+        {
+            return P0 == other.P0 && P1 == other.P1 && P2 == other.P2 && P3 == other.P3;
+        }
+    };
+
+    /// One tube in the merged buffers: the connection it draws and what
+    /// decides whether it is drawn this frame.
+    struct WireEntry {
+        size_t connection = 0;       // index into graph.connections
+        ConnectionKey key = 0;
+        int fromRow = 0;             // endpoint rows in the component store
+        int toRow = 0;
+        uint32_t firstVertex = 0;    // first ring vertex in m_wireVertices
+        int fromLayer = 0;
+        int toLayer = 0;
+        bool looped = false;
+        BezierParams curve;
     };
-    std::vector<BezierParams> m_bezierCache;
+    std::vector<WireEntry> m_wires;
+    std::vector<WireVertex> m_wireVertices;
+    std::vector<WireVertex> m_spareVertices;   // previous vertex storage, reused by the next build
+    std::vector<uint32_t> m_wireIndices;
+    std::vector<size_t> m_wireIndexOffsets;    // first index of each wire, plus the total
+    int m_wireVertexCapacity = 0;
+    size_t m_uploadedVertexCount = 0;          // vertices already on the GPU for the current list
+
+    // Endpoint state the wires were last built from, one entry per store
+    // row, and the wire drawn for each connection.
     std::vector<glm::vec3> m_cachedPositions;
-    std::vector<Connection> m_cachedConnections;
+    std::vector<int> m_cachedLayers;
+    RowWireLookup m_rowWires;
+    uint64_t m_cachedTopologyVersion = 0;
+    uint64_t m_cachedComponentRevision = 0;
+    std::vector<uint32_t> m_editedRows;   // store rows rewritten since m_cachedComponentRevision
+
+    /// A wire list being prepared off the render thread. Everything the
+    /// frame draws stays untouched until it is swapped in whole.
+    struct WireBuild {
+        std::vector<WireEntry> wires;
+        std::vector<WireVertex> vertices;
+        std::vector<glm::vec3> positions;
+        std::vector<int> layers;
+        RowWireLookup rowWires;
+        std::vector<uint32_t> tessellate;   // wires whose rings must be generated
+        std::vector<uint32_t> reuse;        // wires copied from the current vertices
+        std::vector<uint32_t> reuseFrom;    // their first vertex in m_wireVertices
+        size_t firstChangedVertex = 0;
+        std::future<void> done;
+    };
+    std::unique_ptr<WireBuild> m_pendingBuild;
+
+    // All tubes share one VAO: rings of vertices, joined into strips by an
+    // index buffer that lists only the wires drawn under m_indexedLayers.
+    GLuint m_wireVao = 0;
+    GLuint m_wireVbo = 0;
+    GLuint m_wireEbo = 0;
+    std::set<int> m_indexedLayers;
+    bool m_wireIndicesDirty = true;
+
+    // GPU tessellation: a (t, angle) template tube drawn once per visible
+    // wire, with the control points in a per-instance buffer.
+    GLuint m_tubeShader = 0;
+    GLuint m_tubePickShader = 0;   // wire_tube.vert with pick.frag
+    GLuint m_tubeVao = 0;
+    GLuint m_tubeVbo = 0;
+    GLuint m_tubeEbo = 0;
+    GLuint m_tubeInstanceVbo = 0;
+    int m_tubeIndexCount = 0;
+    std::vector<WireInstance> m_wireInstances;
+    std::vector<int> m_wireInstanceIndex;   // instance per wire, or -1 when not drawn
+    int m_wireInstanceCapacity = 0;
+
+    // Signal spheres: one instance per drawn wire whose signal is enabled,
+    // re-listed when the drawn wires or the toggles change.
+    GLuint m_signalShader = 0;
+    GLuint m_signalInstanceVbo = 0;
+    std::vector<SignalInstance> m_signalInstances;
+    std::vector<int> m_wireSignalIndex;   // signal instance per wire, or -1
+    int m_signalInstanceCapacity = 0;
+    uint64_t m_signalRevision = 0;        // signalEnabledRevision at the last listing
+    bool m_signalsDirty = true;
 
     int m_modelLoc = -1;
     int m_viewLoc = -1;
     int m_projectionLoc = -1;
     int m_colorLoc = -1;
+    int m_useVertexColorLoc = -1;
+    int m_tubeViewLoc = -1;
+    int m_tubeProjectionLoc = -1;
+    int m_tubeRadiusLoc = -1;
+    int m_wirePickModelLoc = -1;
+    int m_wirePickViewLoc = -1;
+    int m_wirePickProjectionLoc = -1;
+    int m_wirePickIdLoc = -1;
+    int m_tubePickViewLoc = -1;
+    int m_tubePickProjectionLoc = -1;
+    int m_tubePickRadiusLoc = -1;
+    int m_signalViewLoc = -1;
+    int m_signalProjectionLoc = -1;
+    int m_signalTimeLoc = -1;
+    int m_signalSpeedLoc = -1;
+    int m_signalRadiusLoc = -1;
+    int m_signalColorLoc = -1;
+
+    /// Create the template tube and its instance buffer.
+    bool initTubeTemplate();
+
+    /// Load the signal shader and attach the instance buffer to the sphere.
+    bool initSignalSpheres();
+
+    /// Rebuild the wire list after a topology change. Wires whose
+    /// connection and curve are unchanged keep their tessellation, and only
+    /// the vertex range from the first changed wire onwards is uploaded.
+    /// CPU tessellation runs on worker threads; the frame keeps drawing the
+    /// previous wires until applyWireBuild() swaps the result in.
+    void rebuildWireMeshes(const CircuitGraph& graph, const std::unordered_set<int>& loopedSet);
+
+    /// Make a finished build current and schedule its vertex upload.
+    void applyWireBuild(WireBuild& build);
+
+    /// Drop the wires built for the previous tessellation mode, waiting
+    /// for any build in flight, so the next draw rebuilds every wire.
+    void switchTessellationMode();
+
+    /// Upload the next slice of not-yet-uploaded wire vertices through a
+    /// mapped range, at most WIRE_UPLOAD_VERTICES_PER_FRAME per call.
+    void uploadPendingVertices();
+
+    /// Re-place only the wires touching components that moved or changed
+    /// layer since the last build, and upload just their ranges.
+    void updateMovedWires(const CircuitGraph& graph);
+
+    /// Set a wire's curve and layers from its endpoints' current rows.
+    void placeWire(WireEntry& wire, const ComponentStore& store) const;
+
+    /// Write one Bezier tube's rings into vertices, which must have room
+    /// for WIRE_VERTEX_COUNT entries.
+    static void writeWireMesh(const BezierParams& bp, const glm::vec3& color, WireVertex* vertices);
 
-    /// Rebuild tube VBOs for the current connection list.
-    void rebuildWireMeshes(const std::vector<Connection>& connections,
-                           const std::vector<Component>& components);
+    /// Rebuild the draw list from the wires visible on the current layers:
+    /// the merged index buffer, or the instance buffer under GPU tessellation.
+    void rebuildWireIndices();
 
-    /// Upload one Bezier tube mesh to a VAO/VBO pair.
-    WireMesh uploadWireMesh(const BezierParams& bp);
+    /// Re-list the signal sphere instances from the drawn wires and the
+    /// per-connection toggles, and upload them.
+    void rebuildSignalInstances();
 
-    /// Draw one animated signal sphere on a cached Bezier curve.
-    void drawSignalSphere(const BezierParams& bp, float elapsedTime,
-                          const glm::mat4& view, const glm::mat4& projection);
+    /// Draw every enabled signal sphere in one instanced call; the shader
+    /// places each one on its curve from elapsedTime.
+    void drawSignalSpheres(float elapsedTime, const glm::mat4& view, const glm::mat4& projection);
 };
@@ -0,0 +1,57 @@
+#include "DeviceModels.h"
+
+DeviceKind ClassifyDevice(ComponentType type)
+{
+    switch (type) {
+    case ComponentType::Battery:
+        return DeviceKind::Battery;
+    case ComponentType::Resistor:
+        return DeviceKind::Resistor;
+    case ComponentType::Capacitor:
+        return DeviceKind::Capacitor;
+    case ComponentType::Inductor:
+        return DeviceKind::Inductor;
+    case ComponentType::Diode:
+        return DeviceKind::Diode;
+    default:
+        return DeviceKind::Generic;
+    }
+}
+
+std::vector<DeviceKind> ClassifyComponents(const ComponentStore& store)
+{
+    const std::vector<ComponentType>& types = store.types();
+    std::vector<DeviceKind> kinds(types.size());
+    for (size_t index = 0; index < types.size(); ++index) {
+        kinds[index] = ClassifyDevice(types[index]);
+    }
+    return kinds;
+}
+
+DeviceBatches BuildDeviceBatches(const CircuitGraph& graph)
+{
+    DeviceBatches batches;
+
+    // Classify every component once from the store's type column, so the
+    // connection walk below only does array lookups.
+    const std::vector<DeviceKind> kinds = ClassifyComponents(graph.componentStore());
+    for (size_t index = 0; index < graph.components.size(); ++index) {
+        batches.components[static_cast<size_t>(kinds[index])].push_back(&graph.components[index]);
+    }
+
+    // Every connection carries the series resistance of both of its endpoints.
+    for (const auto& connection : graph.connections) {
+        const int fromIndex = graph.indexOf(connection.from_id);
+        const int toIndex = graph.indexOf(connection.to_id);
+        if (fromIndex < 0 || toIndex < 0) {
+            continue;
+        }
+
+        const Component* from = &graph.components[static_cast<size_t>(fromIndex)];
+        const Component* to = &graph.components[static_cast<size_t>(toIndex)];
+        batches.stamps[static_cast<size_t>(kinds[static_cast<size_t>(fromIndex)])].push_back({from, fromIndex, toIndex});
+        batches.stamps[static_cast<size_t>(kinds[static_cast<size_t>(toIndex)])].push_back({to, fromIndex, toIndex});
+    }
+
+    return batches;
+}
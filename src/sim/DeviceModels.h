@@ -0,0 +1,217 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../circuit/Circuit.h"
+
+/// Electrical device families the solvers know how to stamp.
+/// Generic covers custom component types, which keep the plain resistor behavior.
+enum class DeviceKind : uint8_t {
+    Battery,
+    Resistor,
+    Capacitor,
+    Inductor,
+    Diode,
+    Generic,
+    Count
+};
+
+constexpr size_t DEVICE_KIND_COUNT = static_cast<size_t>(DeviceKind::Count);
+
+/// Inductors are treated as near-short-circuits in DC analysis.
+/// A tiny series resistance prevents division-by-zero in the
+/// conductance matrix while preserving near-zero DC voltage drop.
+constexpr float INDUCTOR_DC_RESISTANCE = 1e-4f;
+
+/// Capacitor charge current falls back to this series resistance when the
+/// component has none, so the forward-Euler update never divides by zero.
+constexpr float CAPACITOR_MIN_SERIES_RESISTANCE = 1e-3f;
+
+/// Maps a component type to its device kind.
+DeviceKind ClassifyDevice(ComponentType type);
+
+/// Device kind of every row of the store.
+std::vector<DeviceKind> ClassifyComponents(const ComponentStore& store);
+
+/// Shared defaults for every device model. Specializations derive from this
+/// (CRTP) and hide only the functions whose behavior differs.
+template <typename Derived>
+struct DeviceModelBase {
+    /// True when the model carries per-step transient state.
+    static constexpr bool HAS_COMPANION = false;
+
+    /// Reports whether the device drives an ideal voltage source at DC.
+    static bool isVoltageSource(const Component&)
+    {
+        return false;
+    }
+
+    /// Writes the DC series resistance and returns true when the device conducts.
+    static bool dcResistance(const Component& component, float& resistance)
+    {
+        resistance = component.resistance;
+
+        // TODO(future): model other ideal zero-resistance parts as KCL constraints.
+        return resistance > 0.0f;
+    }
+
+    /// Advances the device's transient state by one timestep.
+    static void companionStep(const Component&, float, float, float&) {}
+};
+
+template <DeviceKind Kind>
+struct DeviceModel : DeviceModelBase<DeviceModel<Kind>> {};
+
+template <>
+struct DeviceModel<DeviceKind::Battery> : DeviceModelBase<DeviceModel<DeviceKind::Battery>> {
+    /// A battery with no source voltage degrades to its internal resistance.
+    static bool isVoltageSource(const Component& component)
+    {
+        return component.voltageSource > 0.0f;
+    }
+
+    static bool dcResistance(const Component& component, float& resistance)
+    {
+        if (isVoltageSource(component)) {
+            return false;
+        }
+        return DeviceModelBase::dcResistance(component, resistance);
+    }
+};
+
+template <>
+struct DeviceModel<DeviceKind::Capacitor> : DeviceModelBase<DeviceModel<DeviceKind::Capacitor>> {
+    static constexpr bool HAS_COMPANION = true;
+
+    /// Capacitor is open circuit at DC.
+    /// Skip it so no DC current path is added to the matrix.
+    static bool dcResistance(const Component&, float&)
+    {
+        return false;
+    }
+
+    /// State is the capacitor voltage, charged through its series resistance.
+    static void companionStep(const Component& component, float nodeVoltage, float dt, float& capVoltage)
+    {
+        if (component.capacitance <= 0.0f) {
+            return;
+        }
+
+        const float R = component.resistance > 0.0f ? component.resistance : CAPACITOR_MIN_SERIES_RESISTANCE;
+        const float I = (nodeVoltage - capVoltage) / R;
+        // Forward-Euler: V[t+dt] = V[t] + (dV/dt)*dt
+        // Approximate - use dt < RC/10 for accurate results.
+        capVoltage += (I / component.capacitance) * dt;
+    }
+};
+
+template <>
+struct DeviceModel<DeviceKind::Inductor> : DeviceModelBase<DeviceModel<DeviceKind::Inductor>> {
+    static constexpr bool HAS_COMPANION = true;
+
+    /// Inductor is short circuit at DC.
+    /// Use tiny resistance to avoid division by zero.
+    static bool dcResistance(const Component&, float& resistance)
+    {
+        resistance = INDUCTOR_DC_RESISTANCE;
+        return true;
+    }
+
+    /// State is the inductor current, integrated from the node voltage.
+    static void companionStep(const Component& component, float nodeVoltage, float dt, float& current)
+    {
+        if (component.inductance <= 0.0f) {
+            return;
+        }
+
+        // Forward-Euler: I[t+dt] = I[t] + (dI/dt)*dt
+        current += (nodeVoltage / component.inductance) * dt;
+    }
+};
+
+/// One conductance contribution: `device` sits on the edge between two nodes.
+/// Nodes are positions in graph.components, not component IDs.
+struct DeviceStamp {
+    const Component* device;
+    int fromNode;
+    int toNode;
+};
+
+/// Components and connection endpoints bucketed by device kind, so assembly
+/// runs one statically dispatched model per batch instead of classifying
+/// each connection's endpoints.
+struct DeviceBatches {
+    std::array<std::vector<const Component*>, DEVICE_KIND_COUNT> components;
+    std::array<std::vector<DeviceStamp>, DEVICE_KIND_COUNT> stamps;
+
+    std::vector<const Component*>& componentsOf(DeviceKind kind)
+    {
+        return components[static_cast<size_t>(kind)];
+    }
+
+    const std::vector<const Component*>& componentsOf(DeviceKind kind) const
+    {
+        return components[static_cast<size_t>(kind)];
+    }
+
+    const std::vector<DeviceStamp>& stampsOf(DeviceKind kind) const
+    {
+        return stamps[static_cast<size_t>(kind)];
+    }
+};
+
+/// Classifies every component once and groups connection endpoints per kind.
+/// Endpoints resolve through the graph's cached id index; connections whose
+/// endpoints are missing are skipped.
+DeviceBatches BuildDeviceBatches(const CircuitGraph& graph);
+
+namespace detail {
+
+template <typename Fn, size_t... Index>
+void forEachDeviceKind(Fn&& fn, std::index_sequence<Index...>)
+{
+    (fn(std::integral_constant<DeviceKind, static_cast<DeviceKind>(Index)>{}), ...);
+}
+
+} // namespace detail
+
+/// Invokes fn once per device kind with the kind as a compile-time constant,
+/// so the body can call DeviceModel<kind> without any runtime dispatch.
+template <typename Fn>
+void ForEachDeviceKind(Fn&& fn)
+{
+    detail::forEachDeviceKind(std::forward<Fn>(fn), std::make_index_sequence<DEVICE_KIND_COUNT>{});
+}
+
+/// Stamps one batch of same-kind devices through stampConductance(from, to, resistance).
+template <DeviceKind Kind, typename StampFn>
+void StampDcBatch(const std::vector<DeviceStamp>& batch, StampFn&& stampConductance)
+{
+    float resistance = 0.0f;
+    for (const DeviceStamp& stamp : batch) {
+        if (DeviceModel<Kind>::dcResistance(*stamp.device, resistance)) {
+            stampConductance(stamp.fromNode, stamp.toNode, resistance);
+        }
+    }
+}
+
+/// Stamps a single device whose kind is only known at runtime. For callers
+/// that walk connections directly instead of pre-sorted batches; the kind
+/// check unrolls into a short compare chain, never a string compare.
+template <typename StampFn>
+void StampDcDevice(DeviceKind kind, const Component& device, int fromNode, int toNode,
+                   StampFn&& stampConductance)
+{
+    ForEachDeviceKind([&](auto candidate) {
+        constexpr DeviceKind Kind = decltype(candidate)::value;
+        float resistance = 0.0f;
+        if (kind == Kind && DeviceModel<Kind>::dcResistance(device, resistance)) {
+            stampConductance(fromNode, toNode, resistance);
+        }
+    });
+}
@@ -1,12 +1,22 @@
 #include "MNASolver.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <limits>
-#include <unordered_map>
+#include <type_traits>
 
 #include <Eigen/Dense>
+#include <Eigen/OrderingMethods>
+#include <Eigen/SparseCore>
+#include <Eigen/SparseLU>
+
+#include "DeviceModels.h"
+#include "../util/ParallelFor.h"
 
 namespace {
 
@@ -16,16 +26,6 @@ struct VoltageSourceStamp {
     float voltage;
 };
 
-/// Inductors are treated as near-short-circuits in DC analysis.
-/// A tiny series resistance prevents division-by-zero in the
-/// conductance matrix while preserving near-zero DC voltage drop.
-static constexpr float INDUCTOR_DC_RESISTANCE = 1e-4f;
-
-bool isBattery(const Component& component)
-{
-    return component.type == "Battery" && component.voltageSource > 0.0f;
-}
-
 int findLowestComponentId(const CircuitGraph& graph)
 {
     int lowest = std::numeric_limits<int>::max();
@@ -37,22 +37,6 @@ int findLowestComponentId(const CircuitGraph& graph)
     return lowest;
 }
 
-bool hasComponentId(const CircuitGraph& graph, int id)
-{
-    for (const auto& component : graph.components) {
-        if (component.id == id) {
-            return true;
-        }
-    }
-    return false;
-}
-
-const Component* findComponent(const std::unordered_map<int, const Component*>& componentsById, int id)
-{
-    auto it = componentsById.find(id);
-    return it == componentsById.end() ? nullptr : it->second;
-}
-
 int findSourcePlusNode(const CircuitGraph& graph, const Component& source, int groundId)
 {
     if (source.id != groundId) {
@@ -74,157 +58,828 @@ int findSourcePlusNode(const CircuitGraph& graph, const Component& source, int g
     return source.id;
 }
 
-bool effectiveDcResistance(const Component& component, float& resistance)
+template <typename Scalar>
+using SparseMatrix = Eigen::SparseMatrix<Scalar>;
+
+template <typename Scalar>
+using DenseVector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+template <typename Scalar>
+using SparseLUSolver = Eigen::SparseLU<SparseMatrix<Scalar>, Eigen::COLAMDOrdering<int>>;
+
+/// Each refinement pass gains roughly log10(1 / (cond * eps_float)) digits,
+/// so a handful of passes reach double accuracy on well-posed boards.
+constexpr int MAX_REFINEMENT_ITERATIONS = 10;
+
+/// Passes allowed on the previous solve's factors before a warm start gives
+/// up and refactors. Each pass shrinks the error by roughly the relative size
+/// of the edit and costs two triangular solves, far less than a refactor.
+constexpr int WARM_START_REFINEMENT_ITERATIONS = 16;
+
+/// A pass that does not at least halve the residual will not reach the stop
+/// test within the pass budget, so refinement gives up early.
+constexpr double MIN_REFINEMENT_CONTRACTION = 0.5;
+
+/// Assembled MNA system G * x = b. The first nodeCount unknowns are node
+/// voltages, the rest are voltage source currents.
+template <typename Scalar>
+struct MNASystem {
+    SparseMatrix<Scalar> G;
+    DenseVector<Scalar> b;
+    int nodeCount = 0;
+    int groundNode = 0;   // node index, not component ID
+    /// False when some node has no conducting path or source back to ground,
+    /// which makes G singular regardless of component values.
+    bool anchored = true;
+};
+
+/// Collects G entries as triplets with ground elimination applied on insert,
+/// so the ground row and column never enter the sparsity pattern. Indices
+/// that were coupled to ground are remembered for the anchoring check.
+template <typename Scalar>
+class SystemBuilder {
+public:
+    explicit SystemBuilder(int groundNode) : groundNode(groundNode) {}
+
+    void add(int row, int col, Scalar value)
+    {
+        if (row == groundNode || col == groundNode) {
+            if (row != col) {
+                groundNeighbours.push_back(row == groundNode ? col : row);
+            }
+            return;
+        }
+        triplets.emplace_back(row, col, value);
+    }
+
+    void stampConductance(int i, int j, float resistance)
+    {
+        const Scalar conductance = Scalar(1) / static_cast<Scalar>(resistance);
+
+        // Conductance stamp - each resistor adds its conductance to both diagonal entries
+        // and subtracts from the off-diagonal entries. This encodes Kirchhoff's current law.
+        add(i, i, conductance);
+        add(j, j, conductance);
+        add(i, j, -conductance);
+        add(j, i, -conductance);
+    }
+
+    std::vector<Eigen::Triplet<Scalar>> triplets;
+    std::vector<int> groundNeighbours;
+
+private:
+    int groundNode;
+};
+
+/// Below this many connections the extra counting and scatter passes of
+/// the parallel merge outweigh what the workers save, so assembly stays on
+/// the calling thread.
+constexpr size_t PARALLEL_ASSEMBLY_MIN_CONNECTIONS = 16384;
+constexpr size_t ASSEMBLY_CONNECTIONS_PER_CHUNK = 8192;
+
+/// Merge scratch is released before reuse once its capacity is this many
+/// times what the current assembly needs and above the floor below it, so
+/// one very large board does not pin its buffers for the rest of the run.
+constexpr size_t SCRATCH_SHRINK_FACTOR = 4;
+constexpr size_t SCRATCH_KEEP_ELEMENTS = size_t(1) << 16;
+
+enum class AssemblyMode {
+    Auto,
+    Serial,
+    Parallel
+};
+
+/// Node and source layout shared by the serial and parallel assembly paths.
+struct AssemblyLayout {
+    int nodeCount = 0;
+    int groundNode = 0;
+    std::vector<VoltageSourceStamp> voltageSources;
+};
+
+/// STEP 1 - Count nodes.
+/// Number of nodes = number of components. Node i is graph.components[i];
+/// IDs map onto nodes through the graph's ID index, so they may be sparse,
+/// negative or far larger than the component count.
+bool prepareLayout(const CircuitGraph& graph, int groundNodeId, AssemblyLayout& layout)
 {
-    if (isBattery(component)) {
+    layout.nodeCount = static_cast<int>(graph.components.size());
+    if (layout.nodeCount == 0) {
         return false;
     }
 
-    resistance = component.resistance;
+    // Also builds the graph's cached index before any parallel region reads it.
+    const ComponentIndex& index = graph.componentIndex();
+    layout.groundNode = index.find(groundNodeId);
+    if (layout.groundNode < 0) {
+        layout.groundNode = index.find(findLowestComponentId(graph));
+    }
+    std::cerr << "[Elec3D] Ground node: " << graph.components[static_cast<size_t>(layout.groundNode)].id << "\n";
+    return true;
+}
 
-    // Capacitor is open circuit at DC.
-    // Skip it so no DC current path is added to the matrix.
-    if (component.type == "Capacitor") {
-        return false;
+void collectVoltageSources(const CircuitGraph& graph, const Component& battery, AssemblyLayout& layout)
+{
+    if (DeviceModel<DeviceKind::Battery>::isVoltageSource(battery)) {
+        const ComponentIndex& index = graph.componentIndex();
+        const int groundId = graph.components[static_cast<size_t>(layout.groundNode)].id;
+        const int sourceNode = index.find(battery.id);
+        const int plusNode = index.find(findSourcePlusNode(graph, battery, groundId));
+        layout.voltageSources.push_back({
+            sourceNode,
+            plusNode < 0 ? sourceNode : plusNode,
+            battery.voltageSource
+        });
     }
+}
 
-    // Inductor is short circuit at DC.
-    // Use tiny resistance to avoid division by zero.
-    if (component.type == "Inductor") {
-        resistance = INDUCTOR_DC_RESISTANCE;
+/// STEP 3 - Stamp voltage sources.
+/// Voltage source stamp - introduces a new unknown (the source current) so the solver
+/// can enforce the voltage constraint exactly.
+template <typename Scalar>
+void stampVoltageSources(const AssemblyLayout& layout, SystemBuilder<Scalar>& builder,
+                         MNASystem<Scalar>& system)
+{
+    for (int sourceIndex = 0; sourceIndex < static_cast<int>(layout.voltageSources.size()); ++sourceIndex) {
+        const VoltageSourceStamp& source = layout.voltageSources[sourceIndex];
+        const int k = layout.nodeCount + sourceIndex;
+        const int plus = source.plusNode;
+        const int minus = layout.groundNode;
+
+        builder.add(plus, k, Scalar(1));
+        builder.add(minus, k, Scalar(-1));
+        builder.add(k, plus, Scalar(1));
+        builder.add(k, minus, Scalar(-1));
+        system.b(k) = static_cast<Scalar>(source.voltage);
+
+        // A source whose terminals collapse onto ground leaves its current unconstrained.
+        if (plus == minus) {
+            system.anchored = false;
+        }
     }
 
-    if (resistance <= 0.0f) {
-        // TODO(future): model other ideal zero-resistance parts as KCL constraints.
-        return false;
+    // STEP 4 - Apply ground node.
+    // Ground elimination - forces the ground node voltage to zero, giving the solver
+    // an absolute reference to work from. Its row and column were skipped above.
+    builder.triplets.emplace_back(layout.groundNode, layout.groundNode, Scalar(1));
+    system.b(layout.groundNode) = Scalar(0);
+}
+
+/// Walks the sparsity pattern outward from every index coupled to ground.
+/// Any node left unvisited floats, which makes G singular for any values.
+template <typename Scalar>
+bool allNodesReachGround(const SparseMatrix<Scalar>& G, int nodeCount, int groundNode,
+                         const std::vector<int>& groundNeighbours)
+{
+    std::vector<char> visited(static_cast<size_t>(G.cols()), 0);
+    std::vector<int> frontier;
+    frontier.reserve(groundNeighbours.size());
+
+    visited[static_cast<size_t>(groundNode)] = 1;
+    for (int index : groundNeighbours) {
+        if (!visited[static_cast<size_t>(index)]) {
+            visited[static_cast<size_t>(index)] = 1;
+            frontier.push_back(index);
+        }
     }
 
+    // Conductance stamps are symmetric, and source rows mirror their
+    // columns, so walking columns reaches everything a row walk would.
+    while (!frontier.empty()) {
+        const int col = frontier.back();
+        frontier.pop_back();
+        for (typename SparseMatrix<Scalar>::InnerIterator it(G, col); it; ++it) {
+            const int row = static_cast<int>(it.row());
+            if (!visited[static_cast<size_t>(row)]) {
+                visited[static_cast<size_t>(row)] = 1;
+                frontier.push_back(row);
+            }
+        }
+    }
+
+    for (int node = 0; node < nodeCount; ++node) {
+        if (!visited[static_cast<size_t>(node)]) {
+            return false;
+        }
+    }
     return true;
 }
 
-void stampConductance(Eigen::MatrixXf& G, int i, int j, float resistance)
+/// Serial reference path: device batches stamp into one triplet list and
+/// Eigen compresses it.
+template <typename Scalar>
+bool assembleSerial(const CircuitGraph& graph, const AssemblyLayout& layout, MNASystem<Scalar>& system)
 {
-    const float conductance = 1.0f / resistance;
+    // Classify every component once; assembly below never compares type strings.
+    const DeviceBatches devices = BuildDeviceBatches(graph);
+
+    AssemblyLayout sourced = layout;
+    for (const Component* battery : devices.componentsOf(DeviceKind::Battery)) {
+        collectVoltageSources(graph, *battery, sourced);
+    }
+
+    const int matrixSize = sourced.nodeCount + static_cast<int>(sourced.voltageSources.size());
+
+    // STEP 2 - Build conductance matrix G (n x n) and RHS vector b (n x 1).
+    // G is collected as triplets; duplicates are summed when it is compressed.
+    SystemBuilder<Scalar> builder(sourced.groundNode);
+    builder.triplets.reserve(graph.connections.size() * 8 + sourced.voltageSources.size() * 2 + 1);
+    system.b = DenseVector<Scalar>::Zero(matrixSize);
+    system.nodeCount = sourced.nodeCount;
+    system.groundNode = sourced.groundNode;
+    system.anchored = true;
 
-    // Conductance stamp - each resistor adds its conductance to both diagonal entries
-    // and subtracts from the off-diagonal entries. This encodes Kirchhoff's current law.
-    G(i, i) += conductance;
-    G(j, j) += conductance;
-    G(i, j) -= conductance;
-    G(j, i) -= conductance;
+    // Each device kind stamps its own batch with a statically dispatched model.
+    const auto stamp = [&builder](int i, int j, float resistance) {
+        builder.stampConductance(i, j, resistance);
+    };
+    ForEachDeviceKind([&](auto kind) {
+        constexpr DeviceKind Kind = decltype(kind)::value;
+        StampDcBatch<Kind>(devices.stampsOf(Kind), stamp);
+    });
+
+    stampVoltageSources(sourced, builder, system);
+
+    system.G.resize(matrixSize, matrixSize);
+    system.G.setFromTriplets(builder.triplets.begin(), builder.triplets.end());
+    system.G.makeCompressed();
+
+    system.anchored = system.anchored
+        && allNodesReachGround(system.G, sourced.nodeCount, sourced.groundNode, builder.groundNeighbours);
+    return true;
 }
 
-} // namespace
+/// Per-range buffers for bucketing one column range. slotOfRow holds
+/// SIZE_MAX for every row between uses.
+struct RangeScratch {
+    std::vector<size_t> colStart;
+    std::vector<size_t> cursor;
+    std::vector<size_t> slotOfRow;
+};
+
+/// Buffers compressParallel keeps between assemblies on the thread that
+/// calls it, so a re-solve of the same board allocates nothing. The range
+/// buffers belong to the range, not to the worker that happens to run it,
+/// so all of it is trimmed and released here.
+template <typename Scalar>
+struct CompressScratch {
+    std::vector<Eigen::Triplet<Scalar>> merged;
+    std::vector<Eigen::Triplet<Scalar>> sorted;
+    std::vector<RangeScratch> ranges;
+};
 
-std::vector<float> MNASolver::solve(const CircuitGraph& graph, int groundNodeId)
+template <typename Scalar>
+CompressScratch<Scalar>& compressScratch()
 {
-    // STEP 1 - Count nodes.
-    // Number of nodes = number of components. Each component.id is a node index.
-    const int n = static_cast<int>(graph.components.size());
-    if (n == 0) {
-        return {};
+    thread_local CompressScratch<Scalar> scratch;
+    return scratch;
+}
+
+/// Frees buffer when it is far larger than the needed elements, so the
+/// resize that follows allocates only what this assembly uses.
+template <typename T>
+void releaseOversized(std::vector<T>& buffer, size_t needed)
+{
+    if (buffer.capacity() > SCRATCH_KEEP_ELEMENTS && buffer.capacity() / SCRATCH_SHRINK_FACTOR > needed) {
+        std::vector<T>().swap(buffer);
     }
+}
 
-    std::unordered_map<int, const Component*> componentsById;
-    componentsById.reserve(graph.components.size());
-    for (const auto& component : graph.components) {
-        if (component.id < 0 || component.id >= n) {
-            std::cerr << "[Elec3D] MNA: component id out of range\n";
-            return {};
+/// Merges per-chunk triplet lists into a compressed column matrix.
+/// Columns are split into one range per chunk: every chunk counts and
+/// scatters its triplets into the ranges, then each range is bucketed by
+/// column and its duplicates summed independently. Both passes are stable,
+/// so duplicate sums run in connection order whatever the thread count.
+template <typename Scalar>
+void compressParallel(const std::vector<SystemBuilder<Scalar>>& chunks, int matrixSize,
+                      SparseMatrix<Scalar>& G)
+{
+    using Triplet = Eigen::Triplet<Scalar>;
+
+    const size_t chunkCount = chunks.size();
+    const size_t rangeCount = chunkCount;
+
+    std::vector<int> rangeBegin(rangeCount + 1);
+    for (size_t range = 0; range <= rangeCount; ++range) {
+        rangeBegin[range] = static_cast<int>(static_cast<size_t>(matrixSize) * range / rangeCount);
+    }
+    std::vector<uint32_t> rangeOfColumn(static_cast<size_t>(matrixSize));
+    for (size_t range = 0; range < rangeCount; ++range) {
+        for (int col = rangeBegin[range]; col < rangeBegin[range + 1]; ++col) {
+            rangeOfColumn[static_cast<size_t>(col)] = static_cast<uint32_t>(range);
         }
-        componentsById[component.id] = &component;
     }
 
-    int groundId = groundNodeId;
-    if (!hasComponentId(graph, groundId)) {
-        groundId = findLowestComponentId(graph);
+    // Count each chunk's triplets per column range.
+    std::vector<std::vector<size_t>> counts(chunkCount, std::vector<size_t>(rangeCount, 0));
+    ParallelForEach(chunkCount, [&](size_t chunk) {
+        for (const Triplet& triplet : chunks[chunk].triplets) {
+            ++counts[chunk][rangeOfColumn[static_cast<size_t>(triplet.col())]];
+        }
+    });
+
+    // Range-major offsets keep chunk order, and so connection order, inside each range.
+    std::vector<std::vector<size_t>> offsets(chunkCount, std::vector<size_t>(rangeCount, 0));
+    std::vector<size_t> rangeStart(rangeCount + 1, 0);
+    size_t total = 0;
+    for (size_t range = 0; range < rangeCount; ++range) {
+        rangeStart[range] = total;
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            offsets[chunk][range] = total;
+            total += counts[chunk][range];
+        }
     }
-    std::cerr << "[Elec3D] Ground node: " << groundId << "\n";
+    rangeStart[rangeCount] = total;
 
-    std::vector<VoltageSourceStamp> voltageSources;
-    for (const auto& component : graph.components) {
-        if (isBattery(component)) {
-            voltageSources.push_back({
-                component.id,
-                findSourcePlusNode(graph, component, groundId),
-                component.voltageSource
-            });
+    CompressScratch<Scalar>& scratch = compressScratch<Scalar>();
+    std::vector<Triplet>& merged = scratch.merged;
+    releaseOversized(merged, total);
+    merged.resize(total);
+    ParallelForEach(chunkCount, [&](size_t chunk) {
+        std::vector<size_t>& cursor = offsets[chunk];
+        for (const Triplet& triplet : chunks[chunk].triplets) {
+            merged[cursor[rangeOfColumn[static_cast<size_t>(triplet.col())]]++] = triplet;
+        }
+    });
+
+    // Bucket each range by column with a counting sort, then sum duplicate
+    // rows per column and order the few survivors by row.
+    std::vector<Triplet>& sorted = scratch.sorted;
+    releaseOversized(sorted, total);
+    sorted.resize(total);
+    scratch.ranges.resize(rangeCount);
+    std::vector<size_t> rangeLength(rangeCount, 0);
+    ParallelForEach(rangeCount, [&](size_t range) {
+        const int firstCol = rangeBegin[range];
+        const int colCount = rangeBegin[range + 1] - firstCol;
+        const size_t begin = rangeStart[range];
+        const size_t end = rangeStart[range + 1];
+
+        RangeScratch& local = scratch.ranges[range];
+        std::vector<size_t>& colStart = local.colStart;
+        releaseOversized(colStart, static_cast<size_t>(colCount) + 1);
+        colStart.assign(static_cast<size_t>(colCount) + 1, 0);
+        for (size_t entry = begin; entry < end; ++entry) {
+            ++colStart[static_cast<size_t>(merged[entry].col() - firstCol) + 1];
+        }
+        for (int col = 0; col < colCount; ++col) {
+            colStart[static_cast<size_t>(col) + 1] += colStart[static_cast<size_t>(col)];
         }
+        std::vector<size_t>& cursor = local.cursor;
+        releaseOversized(cursor, static_cast<size_t>(colCount));
+        cursor.assign(colStart.begin(), colStart.end() - 1);
+        for (size_t entry = begin; entry < end; ++entry) {
+            sorted[begin + cursor[static_cast<size_t>(merged[entry].col() - firstCol)]++] = merged[entry];
+        }
+
+        // slotOfRow maps a row to its compacted slot in the current column.
+        std::vector<size_t>& slotOfRow = local.slotOfRow;
+        releaseOversized(slotOfRow, static_cast<size_t>(matrixSize));
+        if (slotOfRow.size() < static_cast<size_t>(matrixSize)) {
+            slotOfRow.resize(static_cast<size_t>(matrixSize), SIZE_MAX);
+        }
+        size_t write = begin;
+        for (int col = 0; col < colCount; ++col) {
+            const size_t columnWrite = write;
+            for (size_t read = begin + colStart[static_cast<size_t>(col)];
+                 read < begin + colStart[static_cast<size_t>(col) + 1]; ++read) {
+                const Triplet& triplet = sorted[read];
+                size_t& slot = slotOfRow[static_cast<size_t>(triplet.row())];
+                if (slot != SIZE_MAX && slot >= columnWrite) {
+                    merged[slot] = Triplet(triplet.row(), triplet.col(), merged[slot].value() + triplet.value());
+                } else {
+                    slot = write;
+                    merged[write++] = triplet;
+                }
+            }
+            std::sort(merged.begin() + static_cast<std::ptrdiff_t>(columnWrite),
+                      merged.begin() + static_cast<std::ptrdiff_t>(write),
+                      [](const Triplet& lhs, const Triplet& rhs) { return lhs.row() < rhs.row(); });
+        }
+        rangeLength[range] = write - begin;
+
+        // Only the rows this range touched need clearing for the next use.
+        for (size_t entry = begin; entry < end; ++entry) {
+            slotOfRow[static_cast<size_t>(sorted[entry].row())] = SIZE_MAX;
+        }
+    });
+
+    std::vector<size_t> rangeBase(rangeCount + 1, 0);
+    for (size_t range = 0; range < rangeCount; ++range) {
+        rangeBase[range + 1] = rangeBase[range] + rangeLength[range];
     }
+    const size_t nonZeros = rangeBase[rangeCount];
 
-    const int matrixSize = n + static_cast<int>(voltageSources.size());
+    G.resize(matrixSize, matrixSize);
+    G.resizeNonZeros(static_cast<Eigen::Index>(nonZeros));
+    int* outer = G.outerIndexPtr();
+    int* inner = G.innerIndexPtr();
+    Scalar* values = G.valuePtr();
 
-    // STEP 2 - Build conductance matrix G (n x n) and RHS vector b (n x 1).
-    // Initialize both to zero, then grow the system for source currents.
-    Eigen::MatrixXf G = Eigen::MatrixXf::Zero(matrixSize, matrixSize);
-    Eigen::VectorXf b = Eigen::VectorXf::Zero(matrixSize);
+    ParallelForEach(rangeCount, [&](size_t range) {
+        size_t read = rangeStart[range];
+        const size_t readEnd = read + rangeLength[range];
+        size_t position = rangeBase[range];
+        for (int col = rangeBegin[range]; col < rangeBegin[range + 1]; ++col) {
+            outer[col] = static_cast<int>(position);
+            while (read < readEnd && merged[read].col() == col) {
+                inner[position] = merged[read].row();
+                values[position] = merged[read].value();
+                ++position;
+                ++read;
+            }
+        }
+    });
+    outer[matrixSize] = static_cast<int>(nonZeros);
+}
 
-    for (const auto& connection : graph.connections) {
-        const Component* from = findComponent(componentsById, connection.from_id);
-        const Component* to = findComponent(componentsById, connection.to_id);
-        if (!from || !to) {
-            continue;
+/// Parallel path: connections are split into contiguous chunks that stamp
+/// into their own triplet buffers, then merged by compressParallel.
+/// Endpoints resolve through the graph's flat ID index, which workers only read.
+template <typename Scalar>
+bool assembleParallel(const CircuitGraph& graph, const AssemblyLayout& layout, MNASystem<Scalar>& system)
+{
+    // Classified from the column store before any worker starts, since the
+    // store is built lazily on first use. Both are indexed by node.
+    const std::vector<DeviceKind> kinds = ClassifyComponents(graph.componentStore());
+    const ComponentIndex& nodeOf = graph.componentIndex();
+
+    AssemblyLayout sourced = layout;
+    for (size_t node = 0; node < kinds.size(); ++node) {
+        if (kinds[node] == DeviceKind::Battery) {
+            collectVoltageSources(graph, graph.components[node], sourced);
+        }
+    }
+
+    const int matrixSize = sourced.nodeCount + static_cast<int>(sourced.voltageSources.size());
+    system.b = DenseVector<Scalar>::Zero(matrixSize);
+    system.nodeCount = sourced.nodeCount;
+    system.groundNode = sourced.groundNode;
+    system.anchored = true;
+
+    // STEP 2 - Build conductance matrix G (n x n) in thread-local triplet buffers.
+    const size_t connectionCount = graph.connections.size();
+    const size_t chunkCount = ChunkCount(connectionCount, ASSEMBLY_CONNECTIONS_PER_CHUNK);
+    std::vector<SystemBuilder<Scalar>> chunks(chunkCount, SystemBuilder<Scalar>(sourced.groundNode));
+
+    ParallelForChunks(connectionCount, chunkCount, [&](size_t chunk, size_t begin, size_t end) {
+        SystemBuilder<Scalar>& builder = chunks[chunk];
+        builder.triplets.reserve((end - begin) * 8);
+        const auto stamp = [&builder](int i, int j, float resistance) {
+            builder.stampConductance(i, j, resistance);
+        };
+
+        // Every connection carries the series resistance of both of its endpoints.
+        for (size_t index = begin; index < end; ++index) {
+            const Connection& connection = graph.connections[index];
+            const int from = nodeOf.find(connection.from_id);
+            const int to = nodeOf.find(connection.to_id);
+            if (from < 0 || to < 0) {
+                continue;
+            }
+
+            StampDcDevice(kinds[static_cast<size_t>(from)], graph.components[static_cast<size_t>(from)], from, to, stamp);
+            StampDcDevice(kinds[static_cast<size_t>(to)], graph.components[static_cast<size_t>(to)], from, to, stamp);
+        }
+    });
+
+    stampVoltageSources(sourced, chunks.front(), system);
+
+    compressParallel(chunks, matrixSize, system.G);
+
+    std::vector<int> groundNeighbours;
+    for (const SystemBuilder<Scalar>& builder : chunks) {
+        groundNeighbours.insert(groundNeighbours.end(),
+                                builder.groundNeighbours.begin(), builder.groundNeighbours.end());
+    }
+    system.anchored = system.anchored
+        && allNodesReachGround(system.G, sourced.nodeCount, sourced.groundNode, groundNeighbours);
+    return true;
+}
+
+/// Builds G and b for the DC operating point in the requested precision.
+/// Returns false when the graph cannot be mapped onto node indices.
+template <typename Scalar>
+bool assembleSystem(const CircuitGraph& graph, int groundNodeId, MNASystem<Scalar>& system,
+                    AssemblyMode mode = AssemblyMode::Auto)
+{
+    AssemblyLayout layout;
+    if (!prepareLayout(graph, groundNodeId, layout)) {
+        return false;
+    }
+
+    if (mode == AssemblyMode::Auto) {
+        mode = graph.connections.size() >= PARALLEL_ASSEMBLY_MIN_CONNECTIONS && WorkerCount() > 1
+            ? AssemblyMode::Parallel
+            : AssemblyMode::Serial;
+    }
+
+    if (mode == AssemblyMode::Parallel) {
+        return assembleParallel(graph, layout, system);
+    }
+
+    // A board small enough for the serial path has no use for merge buffers
+    // left by a larger one.
+    compressScratch<Scalar>() = CompressScratch<Scalar>();
+    return assembleSerial(graph, layout, system);
+}
+
+/// Symbolic analysis (COLAMD ordering, elimination tree, supernode layout)
+/// of the last sparsity pattern factored on this thread. Edits that only
+/// change component values keep the pattern, so they pay for a numeric
+/// refactorization only. The numeric factors are kept too, so a warm start
+/// can try them before refactoring at all.
+template <typename FactorScalar>
+struct SymbolicCache {
+    SparseLUSolver<FactorScalar> lu;
+    uint64_t fingerprint = 0;
+    std::vector<int> outerIndex;
+    std::vector<int> innerIndex;
+    bool analyzed = false;
+    bool factored = false;
+    int analysisCount = 0;
+    int factorizationCount = 0;
+};
+
+template <typename FactorScalar>
+SymbolicCache<FactorScalar>& symbolicCache()
+{
+    thread_local SymbolicCache<FactorScalar> cache;
+    return cache;
+}
+
+/// FNV-1a over the compressed column structure. Values are ignored.
+template <typename Scalar>
+uint64_t patternFingerprint(const SparseMatrix<Scalar>& G)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](int value) {
+        hash ^= static_cast<uint64_t>(static_cast<uint32_t>(value));
+        hash *= 1099511628211ull;
+    };
+
+    mix(static_cast<int>(G.rows()));
+    mix(static_cast<int>(G.cols()));
+    for (int col = 0; col <= G.outerSize(); ++col) {
+        mix(G.outerIndexPtr()[col]);
+    }
+    for (int entry = 0; entry < G.nonZeros(); ++entry) {
+        mix(G.innerIndexPtr()[entry]);
+    }
+    return hash;
+}
+
+/// The fingerprint rejects almost every changed pattern cheaply; the
+/// stored structure confirms a match so a hash collision cannot reuse
+/// the wrong elimination tree.
+template <typename FactorScalar>
+bool matchesCachedPattern(const SymbolicCache<FactorScalar>& cache, const SparseMatrix<FactorScalar>& G,
+                          uint64_t fingerprint)
+{
+    return cache.analyzed
+        && cache.fingerprint == fingerprint
+        && cache.outerIndex.size() == static_cast<size_t>(G.outerSize() + 1)
+        && cache.innerIndex.size() == static_cast<size_t>(G.nonZeros())
+        && std::equal(cache.outerIndex.begin(), cache.outerIndex.end(), G.outerIndexPtr())
+        && std::equal(cache.innerIndex.begin(), cache.innerIndex.end(), G.innerIndexPtr());
+}
+
+/// Factors G, redoing the symbolic analysis only when its pattern differs
+/// from the cached one. Returns nullptr when a pivot vanishes.
+template <typename FactorScalar>
+const SparseLUSolver<FactorScalar>* factorCached(const SparseMatrix<FactorScalar>& G)
+{
+    SymbolicCache<FactorScalar>& cache = symbolicCache<FactorScalar>();
+    const uint64_t fingerprint = patternFingerprint(G);
+
+    if (!matchesCachedPattern(cache, G, fingerprint)) {
+        const int* outer = G.outerIndexPtr();
+        const int* inner = G.innerIndexPtr();
+        cache.lu.analyzePattern(G);
+        cache.fingerprint = fingerprint;
+        cache.outerIndex.assign(outer, outer + G.outerSize() + 1);
+        cache.innerIndex.assign(inner, inner + G.nonZeros());
+        cache.analyzed = true;
+        ++cache.analysisCount;
+    }
+
+    cache.lu.factorize(G);
+    ++cache.factorizationCount;
+    cache.factored = cache.lu.info() == Eigen::Success;
+    return cache.factored ? &cache.lu : nullptr;
+}
+
+/// Factors left by the previous solve on this thread, if they were built
+/// for a matrix with the same pattern as G. Their values may be stale.
+template <typename FactorScalar>
+const SparseLUSolver<FactorScalar>* previousFactors(const SparseMatrix<FactorScalar>& G)
+{
+    const SymbolicCache<FactorScalar>& cache = symbolicCache<FactorScalar>();
+    if (!cache.factored || !matchesCachedPattern(cache, G, patternFingerprint(G))) {
+        return nullptr;
+    }
+    return &cache.lu;
+}
+
+/// Largest absolute row sum of G.
+template <typename Scalar>
+Scalar infinityNorm(const SparseMatrix<Scalar>& G)
+{
+    DenseVector<Scalar> rowSums = DenseVector<Scalar>::Zero(G.rows());
+    for (int col = 0; col < G.outerSize(); ++col) {
+        for (typename SparseMatrix<Scalar>::InnerIterator it(G, col); it; ++it) {
+            rowSums(it.row()) += std::abs(it.value());
         }
+    }
+    return rowSums.maxCoeff();
+}
 
-        float resistance = 0.0f;
-        if (effectiveDcResistance(*from, resistance)) {
-            stampConductance(G, from->id, to->id, resistance);
+/// Iterative refinement: the residual is recomputed in Scalar against the
+/// current G and corrected through lu, which may be narrower than Scalar or
+/// built for slightly different values. Returns true once the solution
+/// passes the backward-error stop test, false when it stops improving.
+template <typename Scalar, typename FactorScalar>
+bool refineSolution(const MNASystem<Scalar>& system, const SparseLUSolver<FactorScalar>& lu,
+                    int maxIterations, DenseVector<Scalar>& solution)
+{
+    // Backward-error stop test in the style of LAPACK dsgesv:
+    // ||r|| <= ||x|| * ||G|| * eps * sqrt(n).
+    const Scalar matrixNorm = infinityNorm(system.G);
+    const Scalar sizeFactor = std::sqrt(static_cast<Scalar>(system.G.rows()));
+    const Scalar epsilon = std::numeric_limits<Scalar>::epsilon();
+
+    Scalar previousResidualNorm = std::numeric_limits<Scalar>::infinity();
+    for (int iteration = 0; solution.allFinite(); ++iteration) {
+        const DenseVector<Scalar> residual = system.b - system.G * solution;
+        const Scalar residualNorm = residual.template lpNorm<Eigen::Infinity>();
+        const Scalar tolerance = solution.template lpNorm<Eigen::Infinity>() * matrixNorm * epsilon * sizeFactor;
+        if (residualNorm <= tolerance) {
+            return true;
         }
-        if (effectiveDcResistance(*to, resistance)) {
-            stampConductance(G, from->id, to->id, resistance);
+        if (iteration == maxIterations
+            || residualNorm > previousResidualNorm * static_cast<Scalar>(MIN_REFINEMENT_CONTRACTION)) {
+            return false;
         }
+        previousResidualNorm = residualNorm;
+
+        const DenseVector<FactorScalar> narrowResidual = residual.template cast<FactorScalar>();
+        solution += lu.solve(narrowResidual).template cast<Scalar>();
     }
+    return false;
+}
 
-    // STEP 3 - Stamp voltage sources.
-    // Voltage source stamp - introduces a new unknown (the source current) so the solver
-    // can enforce the voltage constraint exactly.
-    for (int sourceIndex = 0; sourceIndex < static_cast<int>(voltageSources.size()); ++sourceIndex) {
-        const VoltageSourceStamp& source = voltageSources[sourceIndex];
-        const int k = n + sourceIndex;
-        const int plus = source.plusNode;
-        const int minus = groundId;
+/// Seeds the unknowns from a previous node-voltage result. Source currents
+/// are not part of that result, so each one is set to whatever closes KCL
+/// at its plus node. Returns false when the guess does not fit this system.
+template <typename Scalar>
+bool seedFromGuess(const MNASystem<Scalar>& system, const std::vector<float>& guess,
+                   DenseVector<Scalar>& solution)
+{
+    if (guess.size() != static_cast<size_t>(system.nodeCount)) {
+        return false;
+    }
 
-        G(plus, k) += 1.0f;
-        G(minus, k) -= 1.0f;
-        G(k, plus) += 1.0f;
-        G(k, minus) -= 1.0f;
-        b(k) = source.voltage;
+    solution = DenseVector<Scalar>::Zero(system.G.rows());
+    for (int node = 0; node < system.nodeCount; ++node) {
+        if (!std::isfinite(guess[static_cast<size_t>(node)])) {
+            return false;
+        }
+        solution(node) = static_cast<Scalar>(guess[static_cast<size_t>(node)]);
     }
+    solution(system.groundNode) = Scalar(0);
 
-    // STEP 4 - Apply ground node.
-    // Ground elimination - forces the ground node voltage to zero, giving the solver
-    // an absolute reference to work from.
-    for (int i = 0; i < matrixSize; ++i) {
-        G(groundId, i) = 0.0f;
-        G(i, groundId) = 0.0f;
+    // Each source column holds a single +1 on its plus-node row once ground
+    // is eliminated, so its current absorbs that row's residual exactly.
+    DenseVector<Scalar> residual = system.b - system.G * solution;
+    for (int k = system.nodeCount; k < system.G.cols(); ++k) {
+        typename SparseMatrix<Scalar>::InnerIterator it(system.G, k);
+        if (it) {
+            solution(k) = residual(it.row());
+            residual(it.row()) = Scalar(0);
+        }
+    }
+    return true;
+}
+
+/// STEP 5 - Solve G * V = b.
+/// The LU factorization runs in FactorScalar. When that is narrower than
+/// Scalar, iterative refinement recomputes the residual in Scalar and solves
+/// for a correction with the same cheap factorization. If the narrow factors
+/// are rank-deficient or refinement stalls, the system is either singular or
+/// too ill-conditioned for FactorScalar, so the solve is redone in Scalar.
+///
+/// With warmStart, solution already holds a seed. A small edit barely moves
+/// G, so the factors of the previous solve usually refine the seed to full
+/// accuracy in a few passes and the numeric factorization is skipped.
+template <typename Scalar, typename FactorScalar>
+bool solveSystem(const MNASystem<Scalar>& system, DenseVector<Scalar>& solution, bool warmStart)
+{
+    if (!system.anchored) {
+        return false;
+    }
+
+    constexpr bool SAME_PRECISION = std::is_same_v<Scalar, FactorScalar>;
+
+    SparseMatrix<FactorScalar> narrowG;
+    if constexpr (!SAME_PRECISION) {
+        narrowG = system.G.template cast<FactorScalar>();
+        narrowG.makeCompressed();
+    }
+    const SparseMatrix<FactorScalar>& factorG = [&]() -> const SparseMatrix<FactorScalar>& {
+        if constexpr (SAME_PRECISION) {
+            return system.G;
+        } else {
+            return narrowG;
+        }
+    }();
+
+    DenseVector<Scalar> seed;
+    if (warmStart) {
+        seed = solution;
+        if (const SparseLUSolver<FactorScalar>* previous = previousFactors(factorG)) {
+            if (refineSolution(system, *previous, WARM_START_REFINEMENT_ITERATIONS, solution)) {
+                return true;
+            }
+        }
     }
-    G(groundId, groundId) = 1.0f;
-    b(groundId) = 0.0f;
 
-    // STEP 5 - Solve G * V = b.
-    Eigen::FullPivLU<Eigen::MatrixXf> solver(G);
-    if (!solver.isInvertible()) {
+    if (const SparseLUSolver<FactorScalar>* lu = factorCached(factorG)) {
+        const DenseVector<FactorScalar> narrowB = system.b.template cast<FactorScalar>();
+        solution = lu->solve(narrowB).template cast<Scalar>();
+
+        if constexpr (SAME_PRECISION) {
+            return solution.allFinite();
+        } else if (refineSolution(system, *lu, MAX_REFINEMENT_ITERATIONS, solution)) {
+            return true;
+        }
+    }
+
+    if constexpr (SAME_PRECISION) {
+        return false;
+    } else {
+        if (warmStart) {
+            solution = seed;
+        }
+        return solveSystem<Scalar, Scalar>(system, solution, warmStart);
+    }
+}
+
+} // namespace
+
+template <typename Scalar, typename FactorScalar>
+std::vector<Scalar> MNASolver::solveAs(const CircuitGraph& graph, int groundNodeId,
+                                       const std::vector<float>& initialGuess)
+{
+    MNASystem<Scalar> system;
+    if (!assembleSystem(graph, groundNodeId, system)) {
+        return {};
+    }
+
+    DenseVector<Scalar> solution;
+    const bool warmStart = seedFromGuess(system, initialGuess, solution);
+    if (!solveSystem<Scalar, FactorScalar>(system, solution, warmStart)) {
         std::cerr << "[Elec3D] MNA: matrix singular, circuit may be disconnected\n";
         return {};
     }
 
-    const Eigen::VectorXf solution = solver.solve(b);
-    std::vector<float> voltages(static_cast<size_t>(n), 0.0f);
-    for (int i = 0; i < n; ++i) {
+    std::vector<Scalar> voltages(static_cast<size_t>(system.nodeCount), Scalar(0));
+    for (int i = 0; i < system.nodeCount; ++i) {
         voltages[static_cast<size_t>(i)] = solution(i);
     }
 
     return voltages;
 }
 
+template std::vector<float> MNASolver::solveAs<float, float>(const CircuitGraph&, int, const std::vector<float>&);
+template std::vector<double> MNASolver::solveAs<double, double>(const CircuitGraph&, int, const std::vector<float>&);
+template std::vector<double> MNASolver::solveAs<double, float>(const CircuitGraph&, int, const std::vector<float>&);
+
+std::vector<float> MNASolver::solve(const CircuitGraph& graph, int groundNodeId,
+                                    SolverPrecision precision)
+{
+    return solve(graph, groundNodeId, {}, precision);
+}
+
+std::vector<float> MNASolver::solve(const CircuitGraph& graph, int groundNodeId,
+                                    const std::vector<float>& initialGuess, SolverPrecision precision)
+{
+    if (precision == SolverPrecision::Single) {
+        return solveAs<float>(graph, groundNodeId, initialGuess);
+    }
+
+    const std::vector<double> voltages = precision == SolverPrecision::Double
+        ? solveAs<double>(graph, groundNodeId, initialGuess)
+        : solveAs<double, float>(graph, groundNodeId, initialGuess);
+    return std::vector<float>(voltages.begin(), voltages.end());
+}
+
 #ifdef ELEC3D_TEST_MNA
 
 void TestMNASolver()
 {
     CircuitGraph graph;
-    graph.components.push_back({0, "Battery", 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
-    graph.components.push_back({1, "Resistor", 2.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
-    graph.components.push_back({2, "Resistor", 4.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
+    graph.components.push_back({0, ComponentType::Battery, 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
+    graph.components.push_back({1, ComponentType::Resistor, 2.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
+    graph.components.push_back({2, ComponentType::Resistor, 4.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
     graph.components[0].voltageSource = 5.0f;
     graph.connections.push_back({0, 1});
     graph.connections.push_back({1, 2});
@@ -245,4 +900,221 @@ void TestMNASolver()
     assert(std::fabs(r1Current - r2Current) <= 0.001f);
 }
 
+/// Mixed precision must land on the double answer even when milliohm and
+/// megaohm parts share a loop, which is where float alone drifts.
+void TestMNASolverMixedPrecision()
+{
+    CircuitGraph graph;
+    graph.components.push_back({0, ComponentType::Battery, 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
+    graph.components.push_back({1, ComponentType::Resistor, 2.0f, 0.0f, 0.0f, 1, 1.0e6f, 0.0f});
+    graph.components.push_back({2, ComponentType::Resistor, 4.0f, 0.0f, 0.0f, 1, 1.0e-3f, 0.0f});
+    graph.components.push_back({3, ComponentType::Inductor, 6.0f, 0.0f, 0.0f, 1, 0.0f, 0.0f});
+    graph.components[0].voltageSource = 5.0f;
+    graph.components[3].inductance = 1e-3f;
+    graph.connections.push_back({0, 1});
+    graph.connections.push_back({1, 2});
+    graph.connections.push_back({2, 3});
+    graph.connections.push_back({3, 0});
+
+    const std::vector<double> reference = MNASolver::solveAs<double>(graph, 0);
+    const std::vector<double> mixed = MNASolver::solveAs<double, float>(graph, 0);
+    assert(!reference.empty());
+    assert(mixed.size() == reference.size());
+    for (size_t i = 0; i < reference.size(); ++i) {
+        assert(std::fabs(mixed[i] - reference[i]) <= 1e-9 * (1.0 + std::fabs(reference[i])));
+    }
+}
+
+/// Value-only edits must reuse the cached symbolic analysis; a topology
+/// edit must redo it. Both must still match a fresh solve.
+void TestMNASolverSymbolicReuse()
+{
+    CircuitGraph graph;
+    graph.components.push_back({0, ComponentType::Battery, 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
+    graph.components.push_back({1, ComponentType::Resistor, 2.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
+    graph.components.push_back({2, ComponentType::Resistor, 4.0f, 0.0f, 0.0f, 1, 20.0f, 0.0f});
+    graph.components[0].voltageSource = 5.0f;
+    graph.connections.push_back({0, 1});
+    graph.connections.push_back({1, 2});
+    graph.connections.push_back({2, 0});
+
+    const SymbolicCache<double>& cache = symbolicCache<double>();
+    const std::vector<double> first = MNASolver::solveAs<double>(graph, 0);
+    assert(!first.empty());
+    const int analysesAfterFirst = cache.analysisCount;
+
+    graph.components[2].resistance = 40.0f;
+    const std::vector<double> edited = MNASolver::solveAs<double>(graph, 0);
+    assert(cache.analysisCount == analysesAfterFirst);
+    assert(edited.size() == first.size());
+    assert(std::fabs(edited[1] - first[1]) > 1e-6);
+
+    graph.components.push_back({3, ComponentType::Resistor, 6.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
+    graph.connections.push_back({1, 3});
+    graph.connections.push_back({3, 0});
+    const std::vector<double> rewired = MNASolver::solveAs<double>(graph, 0);
+    assert(cache.analysisCount == analysesAfterFirst + 1);
+    assert(rewired.size() == 4);
+}
+
+/// A warm start after a small value edit must converge on the previous
+/// factors without refactoring and land on the cold-start answer.
+void TestMNASolverWarmStart()
+{
+    CircuitGraph graph;
+    graph.components.push_back({0, ComponentType::Battery, 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
+    graph.components.push_back({1, ComponentType::Resistor, 2.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
+    graph.components.push_back({2, ComponentType::Resistor, 4.0f, 0.0f, 0.0f, 1, 20.0f, 0.0f});
+    graph.components.push_back({3, ComponentType::Resistor, 6.0f, 0.0f, 0.0f, 1, 30.0f, 0.0f});
+    graph.components[0].voltageSource = 5.0f;
+    graph.connections.push_back({0, 1});
+    graph.connections.push_back({1, 2});
+    graph.connections.push_back({2, 3});
+    graph.connections.push_back({3, 0});
+
+    const SymbolicCache<float>& cache = symbolicCache<float>();
+    const std::vector<float> first = MNASolver::solve(graph, 0);
+    assert(!first.empty());
+    const int factorizationsAfterFirst = cache.factorizationCount;
+
+    const std::vector<float> unchanged = MNASolver::solve(graph, 0, first);
+    assert(cache.factorizationCount == factorizationsAfterFirst);
+    for (size_t i = 0; i < first.size(); ++i) {
+        assert(std::fabs(unchanged[i] - first[i]) <= 1e-6f);
+    }
+
+    graph.components[2].resistance = 21.0f;
+    const std::vector<float> warm = MNASolver::solve(graph, 0, unchanged);
+    assert(cache.factorizationCount == factorizationsAfterFirst);
+    const std::vector<double> cold = MNASolver::solveAs<double>(graph, 0);
+    assert(warm.size() == cold.size());
+    for (size_t i = 0; i < cold.size(); ++i) {
+        assert(std::fabs(warm[i] - cold[i]) <= 1e-5 * (1.0 + std::fabs(cold[i])));
+    }
+}
+
+/// IDs are remapped onto dense nodes, so a board whose IDs are sparse and
+/// out of order must solve to the same voltages as its 0..n-1 twin.
+void TestMNASolverSparseIds()
+{
+    CircuitGraph dense;
+    dense.components.push_back({0, ComponentType::Battery, 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
+    dense.components.push_back({1, ComponentType::Resistor, 2.0f, 0.0f, 0.0f, 1, 10.0f, 0.0f});
+    dense.components.push_back({2, ComponentType::Resistor, 4.0f, 0.0f, 0.0f, 1, 30.0f, 0.0f});
+    dense.components[0].voltageSource = 5.0f;
+    dense.connections.push_back({0, 1});
+    dense.connections.push_back({1, 2});
+    dense.connections.push_back({2, 0});
+
+    const int SPARSE_IDS[] = {70000, 1001, 3};
+    CircuitGraph sparse = dense;
+    for (size_t i = 0; i < sparse.components.size(); ++i) {
+        sparse.components[i].id = SPARSE_IDS[i];
+    }
+    for (auto& connection : sparse.connections) {
+        connection.from_id = SPARSE_IDS[connection.from_id];
+        connection.to_id = SPARSE_IDS[connection.to_id];
+    }
+    sparse.markTopologyChanged();
+
+    const std::vector<double> expected = MNASolver::solveAs<double>(dense, 0);
+    const std::vector<double> actual = MNASolver::solveAs<double>(sparse, SPARSE_IDS[0]);
+    assert(!expected.empty());
+    assert(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        assert(std::fabs(actual[i] - expected[i]) <= 1e-9 * (1.0 + std::fabs(expected[i])));
+    }
+}
+
+/// Ring board with a skip connection per node, so every node has four
+/// neighbours and the matrix looks like a routed PCB rather than a chain.
+static CircuitGraph buildRingBoard(int nodeCount)
+{
+    static const ComponentType TYPES[] = {
+        ComponentType::Resistor, ComponentType::Resistor, ComponentType::Inductor, ComponentType::Capacitor};
+
+    CircuitGraph graph;
+    graph.components.reserve(static_cast<size_t>(nodeCount));
+    graph.connections.reserve(static_cast<size_t>(nodeCount) * 2);
+    graph.components.push_back({0, ComponentType::Battery, 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
+    graph.components[0].voltageSource = 5.0f;
+    for (int id = 1; id < nodeCount; ++id) {
+        graph.components.push_back({id, TYPES[id % 4], 0.0f, 0.0f, 0.0f, 1, 1.0f + static_cast<float>(id % 97), 0.0f});
+    }
+    for (int id = 0; id < nodeCount; ++id) {
+        graph.connections.push_back({id, (id + 1) % nodeCount});
+        graph.connections.push_back({id, (id + 7) % nodeCount});
+    }
+    return graph;
+}
+
+/// The parallel merge must produce exactly the serial pattern and, up to
+/// summation order, the same values.
+void TestMNAParallelAssembly()
+{
+    const CircuitGraph graph = buildRingBoard(20000);
+
+    MNASystem<double> serial;
+    MNASystem<double> parallel;
+    assert(assembleSystem(graph, 0, serial, AssemblyMode::Serial));
+    assert(assembleSystem(graph, 0, parallel, AssemblyMode::Parallel));
+
+    assert(serial.anchored && parallel.anchored);
+    assert(serial.b == parallel.b);
+    assert(serial.G.rows() == parallel.G.rows());
+    assert(serial.G.nonZeros() == parallel.G.nonZeros());
+    assert(std::equal(serial.G.outerIndexPtr(), serial.G.outerIndexPtr() + serial.G.outerSize() + 1,
+                      parallel.G.outerIndexPtr()));
+    assert(std::equal(serial.G.innerIndexPtr(), serial.G.innerIndexPtr() + serial.G.nonZeros(),
+                      parallel.G.innerIndexPtr()));
+    for (Eigen::Index entry = 0; entry < serial.G.nonZeros(); ++entry) {
+        const double expected = serial.G.valuePtr()[entry];
+        assert(std::fabs(parallel.G.valuePtr()[entry] - expected) <= 1e-12 * (1.0 + std::fabs(expected)));
+    }
+}
+
+/// Merge scratch left by a large board must not outlive it: a much smaller
+/// parallel assembly trims it, and a serial one releases it.
+void TestMNAScratchRelease()
+{
+    MNASystem<double> system;
+    assert(assembleSystem(buildRingBoard(200000), 0, system, AssemblyMode::Parallel));
+    const CompressScratch<double>& scratch = compressScratch<double>();
+    const size_t largeCapacity = scratch.merged.capacity();
+    assert(largeCapacity > SCRATCH_KEEP_ELEMENTS);
+
+    assert(assembleSystem(buildRingBoard(20000), 0, system, AssemblyMode::Parallel));
+    assert(scratch.merged.capacity() * SCRATCH_SHRINK_FACTOR <= largeCapacity);
+    for (const RangeScratch& range : scratch.ranges) {
+        assert(range.slotOfRow.capacity() < 200000);
+    }
+
+    assert(assembleSystem(buildRingBoard(20000), 0, system, AssemblyMode::Serial));
+    assert(scratch.merged.capacity() == 0 && scratch.sorted.capacity() == 0 && scratch.ranges.empty());
+}
+
+/// Prints serial and parallel assembly times for a board of the given size.
+void BenchmarkMNAAssembly(int connectionCount)
+{
+    const CircuitGraph graph = buildRingBoard(connectionCount / 2);
+
+    const auto bestOf = [&graph](AssemblyMode mode) {
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < 3; ++run) {
+            MNASystem<double> system;
+            const auto start = std::chrono::steady_clock::now();
+            assembleSystem(graph, 0, system, mode);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    };
+
+    const double serialMs = bestOf(AssemblyMode::Serial);
+    const double parallelMs = bestOf(AssemblyMode::Parallel);
+    std::cout << "[Elec3D] MNA assembly, " << graph.connections.size() << " connections: serial "
+              << serialMs << " ms, parallel " << parallelMs << " ms on "
+              << WorkerCount() << " workers\n";
+}
+
 #endif
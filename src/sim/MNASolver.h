@@ -4,14 +4,48 @@
 
 #include "../circuit/Circuit.h"
 
+/// Arithmetic used to factor and solve the MNA system.
+enum class SolverPrecision {
+    Single,         ///< float assembly, factorization and solve.
+    Double,         ///< double assembly, factorization and solve.
+    MixedRefined    ///< float factorization, double iterative refinement.
+};
+
 class MNASolver {
 public:
     /// Solve the DC operating point of the circuit.
     /// Returns one voltage per component node.
-    /// Index matches component.id.
+    /// Index matches the component's position in graph.components, so IDs
+    /// need not be dense; groundNodeId is a component ID.
     /// Returns empty vector if circuit is unsolvable.
+    /// MixedRefined gives double-accurate voltages at close to float
+    /// factorization cost, which matters when mOhm and MOhm parts share a board.
+    /// The sparse symbolic analysis is cached per thread and reused while the
+    /// sparsity pattern is unchanged, so value-only edits refactor numerically.
     static std::vector<float> solve(
         const CircuitGraph& graph,
-        int groundNodeId
+        int groundNodeId,
+        SolverPrecision precision = SolverPrecision::MixedRefined
+    );
+
+    /// Warm-started solve. initialGuess is a previous result for the same
+    /// circuit, such as last frame's voltages. After a small edit the previous
+    /// factorization refines it to full accuracy in a few passes, skipping
+    /// the refactorization. A guess whose size does not match is ignored.
+    static std::vector<float> solve(
+        const CircuitGraph& graph,
+        int groundNodeId,
+        const std::vector<float>& initialGuess,
+        SolverPrecision precision = SolverPrecision::MixedRefined
+    );
+
+    /// Solve with assembly and residuals in Scalar and the LU factorization in
+    /// FactorScalar. A narrower FactorScalar enables iterative refinement.
+    /// Instantiated for <float, float>, <double, double> and <double, float>.
+    template <typename Scalar, typename FactorScalar = Scalar>
+    static std::vector<Scalar> solveAs(
+        const CircuitGraph& graph,
+        int groundNodeId,
+        const std::vector<float>& initialGuess = {}
     );
 };
@@ -1,12 +1,13 @@
 #include "TransientSolver.h"
 
+#include "DeviceModels.h"
 #include "MNASolver.h"
 
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 #include <sstream>
-#include <unordered_map>
 
 std::vector<float> TransientSolver::solve(
     const CircuitGraph& graph,
@@ -24,67 +25,71 @@ std::vector<float> TransientSolver::solve(
     std::vector<float> history;
     history.reserve(static_cast<size_t>(steps));
 
-    std::unordered_map<int, float> capVoltage;
-    std::unordered_map<int, float> indCurrent;
-    for (const auto& component : graph.components) {
-        capVoltage[component.id] = 0.0f;
-        indCurrent[component.id] = 0.0f;
+    // Reactive devices are batched per kind once; the time loop below runs
+    // each kind's companion update without looking at type strings.
+    const DeviceBatches devices = BuildDeviceBatches(graph);
+
+    // One state slot per batched device: capacitor voltage or inductor current.
+    // The solver returns voltages by node, so each device's node is resolved
+    // from its id once here rather than every step.
+    std::array<std::vector<float>, DEVICE_KIND_COUNT> companionState;
+    std::array<std::vector<int>, DEVICE_KIND_COUNT> deviceNodes;
+    for (size_t kind = 0; kind < DEVICE_KIND_COUNT; ++kind) {
+        companionState[kind].assign(devices.components[kind].size(), 0.0f);
+        deviceNodes[kind].reserve(devices.components[kind].size());
+        for (const Component* device : devices.components[kind]) {
+            deviceNodes[kind].push_back(graph.indexOf(device->id));
+        }
     }
-
-    const Component* observedComponent = nullptr;
-    for (const auto& component : graph.components) {
-        if (component.id == observeNode) {
-            observedComponent = &component;
+    const int observedNode = graph.indexOf(observeNode);
+
+    // The observed node reports capacitor voltage when it is a charging capacitor.
+    const float* observedCapVoltage = nullptr;
+    const auto& capacitors = devices.componentsOf(DeviceKind::Capacitor);
+    for (size_t i = 0; i < capacitors.size(); ++i) {
+        if (capacitors[i]->id == observeNode && capacitors[i]->capacitance > 0.0f) {
+            observedCapVoltage = &companionState[static_cast<size_t>(DeviceKind::Capacitor)][i];
             break;
         }
     }
 
     // STEP 2 - Time loop.
+    // Each step warm-starts from the previous step's voltages, which lets the
+    // solver reuse its factorization instead of refactoring every step.
+    std::vector<float> nodeVoltages;
     for (int step = 0; step < steps; ++step) {
         std::ostringstream solverLogSink;
         std::streambuf* originalCerr = std::cerr.rdbuf(solverLogSink.rdbuf());
-        std::vector<float> nodeVoltages = MNASolver::solve(graph, groundNodeId);
+        nodeVoltages = MNASolver::solve(graph, groundNodeId, nodeVoltages);
         std::cerr.rdbuf(originalCerr);
         if (nodeVoltages.empty()) {
             history.push_back(0.0f);
             continue;
         }
 
-        for (const auto& cap : graph.components) {
-            if (cap.capacitance <= 0.0f) {
-                continue;
-            }
-
-            float V = 0.0f;
-            if (cap.id >= 0 && cap.id < static_cast<int>(nodeVoltages.size())) {
-                V = nodeVoltages[static_cast<size_t>(cap.id)];
-            }
-            float R = cap.resistance > 0.0f ? cap.resistance : 1e-3f;
-            float I = (V - capVoltage[cap.id]) / R;
-            // Forward-Euler: V[t+dt] = V[t] + (dV/dt)*dt
-            // Approximate - use dt < RC/10 for accurate results.
-            capVoltage[cap.id] += (I / cap.capacitance) * dt;
-        }
-
-        for (const auto& ind : graph.components) {
-            if (ind.inductance <= 0.0f) {
-                continue;
+        ForEachDeviceKind([&](auto kind) {
+            constexpr DeviceKind Kind = decltype(kind)::value;
+            using Model = DeviceModel<Kind>;
+            if constexpr (Model::HAS_COMPANION) {
+                const auto& batch = devices.componentsOf(Kind);
+                const std::vector<int>& nodes = deviceNodes[static_cast<size_t>(Kind)];
+                std::vector<float>& state = companionState[static_cast<size_t>(Kind)];
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    const Component& device = *batch[i];
+                    float V = 0.0f;
+                    if (nodes[i] >= 0 && nodes[i] < static_cast<int>(nodeVoltages.size())) {
+                        V = nodeVoltages[static_cast<size_t>(nodes[i])];
+                    }
+                    Model::companionStep(device, V, dt, state[i]);
+                }
             }
-
-            float V = 0.0f;
-            if (ind.id >= 0 && ind.id < static_cast<int>(nodeVoltages.size())) {
-                V = nodeVoltages[static_cast<size_t>(ind.id)];
-            }
-            // Forward-Euler: V[t+dt] = V[t] + (dV/dt)*dt
-            // Approximate - use dt < RC/10 for accurate results.
-            indCurrent[ind.id] += (V / ind.inductance) * dt;
-        }
+        });
 
         float observedVoltage = 0.0f;
-        if (observedComponent && observedComponent->capacitance > 0.0f) {
-            observedVoltage = capVoltage[observeNode];
-        } else if (observeNode >= 0 && observeNode < static_cast<int>(nodeVoltages.size())) {
-            observedVoltage = nodeVoltages[static_cast<size_t>(observeNode)];
+        if (observedCapVoltage) {
+            observedVoltage = *observedCapVoltage;
+        } else if (observedNode >= 0 && observedNode < static_cast<int>(nodeVoltages.size())) {
+            observedVoltage = nodeVoltages[static_cast<size_t>(observedNode)];
         }
         history.push_back(observedVoltage);
     }
@@ -97,9 +102,9 @@ std::vector<float> TransientSolver::solve(
 void TestTransientSolver()
 {
     CircuitGraph graph;
-    graph.components.push_back({0, "Battery", 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
-    graph.components.push_back({1, "Resistor", 2.0f, 0.0f, 0.0f, 1, 1000.0f, 0.0f});
-    graph.components.push_back({2, "Capacitor", 4.0f, 0.0f, 0.0f, 1, 1000.0f, 0.0f});
+    graph.components.push_back({0, ComponentType::Battery, 0.0f, 0.0f, 0.0f, 1, 0.1f, 5.0f});
+    graph.components.push_back({1, ComponentType::Resistor, 2.0f, 0.0f, 0.0f, 1, 1000.0f, 0.0f});
+    graph.components.push_back({2, ComponentType::Capacitor, 4.0f, 0.0f, 0.0f, 1, 1000.0f, 0.0f});
     graph.components[0].voltageSource = 5.0f;
     graph.components[2].capacitance = 1e-6f;
     graph.connections.push_back({0, 1});
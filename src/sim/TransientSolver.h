@@ -10,6 +10,7 @@ public:
     /// dt:          timestep in seconds (e.g. 1e-5)
     /// tTotal:      total simulation time in seconds (e.g. 5e-3)
     /// observeNode: component id whose voltage is recorded.
+    /// groundNodeId: component id; ids need not be dense.
     /// Returns one voltage sample per timestep.
     /// Returns empty vector if circuit is unsolvable.
     static std::vector<float> solve(
@@ -0,0 +1,117 @@
+#include "ParallelFor.h"
+
+#include <cstdlib>
+
+namespace {
+// Set on pool workers, and on a caller while its loop owns the pool. A loop
+// started from such a thread runs inline rather than waiting on itself.
+thread_local bool t_insideLoop = false;
+} // namespace
+
+size_t WorkerCount()
+{
+    static const size_t count = []() -> size_t {
+        if (const char* forced = std::getenv("ELEC3D_WORKERS")) {
+            const long value = std::strtol(forced, nullptr, 10);
+            if (value > 0) {
+                return static_cast<size_t>(value);
+            }
+        }
+        const unsigned hardware = std::thread::hardware_concurrency();
+        return hardware == 0 ? 1 : static_cast<size_t>(hardware);
+    }();
+    return count;
+}
+
+WorkerPool& WorkerPool::shared()
+{
+    static WorkerPool pool(WorkerCount() - 1);
+    return pool;
+}
+
+WorkerPool::WorkerPool(size_t threadCount)
+{
+    m_threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(size_t chunkCount, Task task, void* context)
+{
+    Job job;
+    job.task = task;
+    job.context = context;
+    job.chunkCount = chunkCount;
+
+    // Nested, nothing to share with, or busy with another loop: run it all here.
+    if (t_insideLoop || m_threads.empty() || chunkCount < 2) {
+        drain(job);
+        return;
+    }
+    std::unique_lock<std::mutex> submit(m_submit, std::try_to_lock);
+    if (!submit.owns_lock()) {
+        drain(job);
+        return;
+    }
+    t_insideLoop = true;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+    }
+    m_wake.notify_all();
+
+    const size_t ran = drain(job);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    job.finished += ran;
+    m_done.wait(lock, [&job]() { return job.finished == job.chunkCount && job.attached == 0; });
+    m_job = nullptr;
+    t_insideLoop = false;
+}
+
+void WorkerPool::workerLoop()
+{
+    t_insideLoop = true;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this]() {
+            return m_stopping || (m_job != nullptr && m_job->nextChunk.load() < m_job->chunkCount);
+        });
+        if (m_stopping) {
+            return;
+        }
+
+        Job& job = *m_job;
+        ++job.attached;
+        lock.unlock();
+        const size_t ran = drain(job);
+        lock.lock();
+        job.finished += ran;
+        --job.attached;
+        m_done.notify_all();
+    }
+}
+
+size_t WorkerPool::drain(Job& job)
+{
+    size_t ran = 0;
+    for (size_t chunk = job.nextChunk.fetch_add(1); chunk < job.chunkCount; chunk = job.nextChunk.fetch_add(1)) {
+        job.task(job.context, chunk);
+        ++ran;
+    }
+    return ran;
+}
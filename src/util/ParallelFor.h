@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Threads a parallel loop may use, counting the calling thread. The
+/// ELEC3D_WORKERS environment variable overrides the hardware count, so a
+/// thread count the host does not have can still be exercised or timed.
+size_t WorkerCount();
+
+/// Number of chunks to split `count` items into so that no chunk holds fewer
+/// than minPerChunk items. Never more than WorkerCount(), never less than 1.
+inline size_t ChunkCount(size_t count, size_t minPerChunk)
+{
+    const size_t byWork = std::max<size_t>(1, count / std::max<size_t>(1, minPerChunk));
+    return std::min(byWork, WorkerCount());
+}
+
+/// WorkerCount() - 1 threads started on first use and kept for the life of
+/// the program, so a parallel loop costs a wake-up instead of thread
+/// creation. One loop runs on them at a time; a loop started while they are
+/// busy, including one nested inside a running loop, runs on its caller.
+class WorkerPool {
+public:
+    using Task = void (*)(void* context, size_t chunk);
+
+    static WorkerPool& shared();
+
+    ~WorkerPool();
+
+    /// Calls task(context, chunk) once for every chunk in [0, chunkCount),
+    /// the calling thread taking chunks alongside the workers. Returns once
+    /// every chunk has finished.
+    void run(size_t chunkCount, Task task, void* context);
+
+private:
+    /// One loop in flight. Lives on the caller's stack; run() returns only
+    /// after every worker that picked it up has let go of it.
+    struct Job {
+        Task task = nullptr;
+        void* context = nullptr;
+        size_t chunkCount = 0;
+        std::atomic<size_t> nextChunk{0};
+        size_t finished = 0;   // guarded by m_mutex
+        size_t attached = 0;   // workers still holding the job, guarded by m_mutex
+    };
+
+    explicit WorkerPool(size_t threadCount);
+
+    void workerLoop();
+
+    /// Runs chunks of job until none are left; returns how many it ran.
+    static size_t drain(Job& job);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_submit;            // held by the caller whose loop owns the workers
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    Job* m_job = nullptr;
+    bool m_stopping = false;
+};
+
+/// Calls fn(chunk, begin, end) for chunkCount contiguous slices of [0, count)
+/// on the shared WorkerPool, the calling thread included. Slices never
+/// overlap, so fn may write per-chunk state indexed by `chunk` without
+/// locking.
+template <typename Fn>
+void ParallelForChunks(size_t count, size_t chunkCount, Fn&& fn)
+{
+    chunkCount = std::max<size_t>(1, std::min(chunkCount, std::max<size_t>(1, count)));
+
+    const auto sliceBegin = [count, chunkCount](size_t chunk) {
+        return count * chunk / chunkCount;
+    };
+    if (chunkCount == 1) {
+        fn(size_t(0), sliceBegin(0), sliceBegin(1));
+        return;
+    }
+
+    auto body = [&fn, &sliceBegin](size_t chunk) {
+        fn(chunk, sliceBegin(chunk), sliceBegin(chunk + 1));
+    };
+    using Body = decltype(body);
+    WorkerPool::shared().run(chunkCount,
+        [](void* context, size_t chunk) { (*static_cast<Body*>(context))(chunk); },
+        &body);
+}
+
+/// Calls fn(task) once for each of taskCount independent tasks, spread over
+/// at most WorkerCount() threads.
+template <typename Fn>
+void ParallelForEach(size_t taskCount, Fn&& fn)
+{
+    ParallelForChunks(taskCount, std::min(taskCount, WorkerCount()),
+        [&fn](size_t, size_t begin, size_t end) {
+            for (size_t task = begin; task < end; ++task) {
+                fn(task);
+            }
+        });
+}